@@ -1,233 +1,212 @@
 // a_star.cpp (updated: respect oneway & drivable ways; nearest-node helper)
 
 #include <iostream>
-#include <unordered_map>
-#include <unordered_set>
 #include <vector>
 #include <queue>
 #include <cmath>
 #include <limits>
-#include <osmium/io/any_input.hpp>
-#include <osmium/handler.hpp>
-#include <osmium/visitor.hpp>
 #include <fstream>
 #include <chrono>
 #include <iomanip>
 #include <sstream>
 #include <algorithm>
 #include <string>
-
-struct Node {
-    double lat, lon;
-};
-struct Edge {
-    int64_t to;
-    double weight;
-};
-
-std::unordered_map<int64_t, Node> nodes;
-std::unordered_map<int64_t, std::vector<Edge>> adj;
-
-constexpr double PI_CONST = 3.14159265358979323846;
-inline double deg2rad(double deg) { return deg * PI_CONST / 180.0; }
-
-double haversine(double lat1, double lon1, double lat2, double lon2) {
-    // Returns distance in meters
-    const double R = 6371000.0; // mean Earth radius in meters
-    double dLat = deg2rad(lat2 - lat1);
-    double dLon = deg2rad(lon2 - lon1);
-    double a = std::sin(dLat / 2.0) * std::sin(dLat / 2.0) +
-               std::cos(deg2rad(lat1)) * std::cos(deg2rad(lat2)) *
-               std::sin(dLon / 2.0) * std::sin(dLon / 2.0);
-    double c = 2.0 * std::atan2(std::sqrt(a), std::sqrt(1.0 - a));
-    return R * c;
-}
-
-// Helper: find nearest node id for a lat/lon (linear search - slow for full map, but fine for testing)
-int64_t findNearestNode(double lat, double lon) {
-    double bestDist = std::numeric_limits<double>::infinity();
-    int64_t bestId = 0;
-    for (const auto &p : nodes) {
-        double d = haversine(lat, lon, p.second.lat, p.second.lon);
-        if (d < bestDist) {
-            bestDist = d;
-            bestId = p.first;
+#include <cstdlib>
+#include <memory>
+
+#include "geo.hpp"
+#include "graph_builder.hpp"
+#include "graph_overlay.hpp"
+#include "graph_set.hpp"
+#include "graph_snapshot.hpp"
+#include "map_data.hpp"
+#include "osm_change.hpp"
+#include "road_graph.hpp"
+#include "search.hpp"
+#include "tiled_graph.hpp"
+
+GraphSet graphs;
+
+// Serves from the mapped graph snapshot when there is a usable one; otherwise the
+// graph is built from the OSM file and the snapshot is written for the next start.
+// The location index can be picked per deployment with ROUTE_TRACER_LOCATION_INDEX
+// (e.g. "flex_mem" or "dense_mmap_array"); by default it follows the input size.
+// ROUTE_TRACER_THREADS limits the loader threads (default: all cores),
+// ROUTE_TRACER_PROFILES picks the graphs to build (default: "car,bike,foot")
+// and ROUTE_TRACER_REGION limits them to a bbox or a .poly/GeoJSON boundary.
+void loadKarachiMap(const std::string& filename, const std::string& snapshot_file) {
+    try {
+        auto start_time = std::chrono::steady_clock::now();
+        graphs = loadSnapshot(snapshot_file);
+        auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start_time);
+        std::cout << "Graph snapshot mapped in " << elapsed.count() / 1000.0 << " ms.\n";
+        for (const RoadGraph& graph : graphs.graphs) {
+            std::cout << "  " << profileName(graph.profile) << ": road nodes: " << graph.numNodes()
+                      << "  Edges: " << graph.numEdges() << "\n";
         }
+        return;
+    } catch (const std::exception& e) {
+        std::cout << "No usable graph snapshot (" << e.what() << "), parsing " << filename << "\n";
     }
-    return bestId;
-}
-
-void loadKarachiMap(const std::string& filename) {
-    struct MapHandler : public osmium::handler::Handler {
-        // set of highway tags that are appropriate for motor vehicle routing
-        const std::unordered_set<std::string> drivables = {
-            "motorway","trunk","primary","secondary","tertiary",
-            "unclassified","residential","service","living_street",
-            "motorway_link","primary_link","secondary_link","tertiary_link"
-        };
-
-        // disallow these (pedestrian/cycle) types explicitly
-        const std::unordered_set<std::string> nondrivable = {
-            "footway","path","cycleway","steps","pedestrian","track","bridleway","corridor"
-        };
-
-        void node(const osmium::Node& node) {
-            if (node.location().valid()) {
-                nodes[node.id()] = {node.location().lat(), node.location().lon()};
-            }
-        }
-
-        void way(const osmium::Way& way) {
-            const char* highway_tag = way.tags()["highway"];
-            if (!highway_tag) return; // not a highway/road-type way
 
-            std::string hw = highway_tag;
-            if (nondrivable.count(hw)) return; // skip pedestrian / cycle / steps etc.
-
-            // allow ways that are in drivables set; if not present, skip to be conservative
-            if (!drivables.count(hw)) {
-                // there are some ambiguous 'road' ways; to be conservative, skip unknown kinds
-                return;
-            }
-
-            // check simple access restrictions
-            const char* access_tag = way.tags()["access"];
-            const char* motor_tag = way.tags()["motor_vehicle"];
-            if ((access_tag && std::string(access_tag) == "no") ||
-                (motor_tag && std::string(motor_tag) == "no")) {
-                return; // not allowed for motor vehicles
-            }
-
-            // determine one-way behavior
-            bool oneway = false;
-            bool oneway_reverse = false;
-            const char* oneway_tag = way.tags()["oneway"];
-            const char* junction_tag = way.tags()["junction"];
-            if (junction_tag && std::string(junction_tag) == "roundabout") {
-                oneway = true;
-            }
-            if (oneway_tag) {
-                std::string ow(oneway_tag);
-                if (ow == "yes" || ow == "true" || ow == "1") oneway = true;
-                else if (ow == "-1") oneway_reverse = true;
-            }
+    GraphBuildOptions options;
+    if (const char* index_type = std::getenv("ROUTE_TRACER_LOCATION_INDEX")) {
+        options.location_index = index_type;
+    }
+    if (const char* threads = std::getenv("ROUTE_TRACER_THREADS")) {
+        options.threads = static_cast<unsigned>(std::strtoul(threads, nullptr, 10));
+    }
 
-            const osmium::WayNodeList& wnl = way.nodes();
-            // add edges according to the directionality indicated by tags
-            for (auto it = wnl.begin(); std::next(it) != wnl.end(); ++it) {
-                int64_t id1 = it->ref();
-                int64_t id2 = std::next(it)->ref();
-                if (!nodes.count(id1) || !nodes.count(id2)) continue; // skip if coordinates unknown
-
-                double d = haversine(nodes[id1].lat, nodes[id1].lon,
-                                     nodes[id2].lat, nodes[id2].lon);
-
-                if (oneway_reverse) {
-                    // edge only from id2 -> id1
-                    adj[id2].push_back({id1, d});
-                } else if (oneway) {
-                    // edge only from id1 -> id2 (way node order)
-                    adj[id1].push_back({id2, d});
-                } else {
-                    // bidirectional (normal two-way street)
-                    adj[id1].push_back({id2, d});
-                    adj[id2].push_back({id1, d});
-                }
-            }
+    try {
+        if (const char* profiles = std::getenv("ROUTE_TRACER_PROFILES")) {
+            options.profiles = parseProfileList(profiles);
+        }
+        if (const char* region = std::getenv("ROUTE_TRACER_REGION")) {
+            options.region = loadRegion(region);
+        }
+        graphs = buildGraphsFromOsm(filename, options);
+        std::cout << "Map loaded successfully!\n";
+        for (RoadGraph& graph : graphs.graphs) {
+            graph.grid = buildSpatialGrid(graph, 0.01);
+            graph.tiles = buildTileIndex(graph, default_tile_bytes);
+            graph.reverse = buildReverseAdjacency(graph);
+            std::cout << "  " << profileName(graph.profile) << ": road nodes: " << graph.numNodes()
+                      << "  Edges: " << graph.numEdges() << "\n";
         }
-    };
+    } catch (const std::exception& e) {
+        std::cerr << "Error reading Karachi map: " << e.what() << "\n";
+        return;
+    }
 
     try {
-        osmium::io::Reader reader(filename);
-        MapHandler handler;
-        osmium::apply(reader, handler);
-        reader.close();
-        std::cout << "Map loaded successfully! Nodes: " << nodes.size()
-                  << "  Adjacencies (non-empty keys): " << adj.size() << "\n";
+        writeSnapshot(graphs, snapshot_file);
+        std::cout << "Graph snapshot written to: " << snapshot_file << "\n";
     } catch (const std::exception& e) {
-        std::cerr << "Error reading Karachi map: " << e.what() << "\n";
+        std::cerr << "Could not write graph snapshot: " << e.what() << "\n";
     }
 }
 
-std::vector<int64_t> astar(int64_t start, int64_t goal) {
-    std::unordered_map<int64_t, double> gScore;
-    std::unordered_map<int64_t, double> fScore;
-    std::unordered_map<int64_t, int64_t> parent;
-
-    gScore[start] = 0.0;
-    fScore[start] = haversine(nodes[start].lat, nodes[start].lon,
-                              nodes[goal].lat, nodes[goal].lon);
-
-    auto cmp = [](const std::pair<int64_t, double>& a, const std::pair<int64_t, double>& b) {
-        return a.second > b.second;
-    };
-    std::priority_queue<std::pair<int64_t, double>,
-                       std::vector<std::pair<int64_t, double>>,
-                       decltype(cmp)> openSet(cmp);
-
-    openSet.push({start, fScore[start]});
-
-    int nodes_explored = 0;
-
-    while (!openSet.empty()) {
-        auto current_pair = openSet.top();
-        openSet.pop();
-        int64_t current = current_pair.first;
-        double current_fscore_in_queue = current_pair.second;
-
-        if (fScore.count(current) && current_fscore_in_queue > fScore[current] + 1e-9) {
-            continue; // stale entry
-        }
-
-        nodes_explored++;
+// Folds overlays[i] into a fresh graphs.graphs[i], with its turn table
+// rebuilt, and starts an empty overlay on it
+static void compactOverlay(std::vector<GraphOverlay>& overlays, std::size_t i) {
+    RoadGraph compacted = overlays[i].compact();
+    graphs.graphs[i] = std::move(compacted);
+    overlays[i] = GraphOverlay(graphs.graphs[i]);
+    std::cout << "Compacted " << profileName(graphs.graphs[i].profile) << " graph. Road nodes: "
+              << graphs.graphs[i].numNodes() << "  Edges: " << graphs.graphs[i].numEdges() << "\n";
+}
 
-        if (current == goal) {
-            std::vector<int64_t> path;
-            for (int64_t at = goal; at != start; at = parent[at]) {
-                path.push_back(at);
+// Applies the OsmChange files listed in ROUTE_TRACER_CHANGES (comma separated,
+// oldest first) on top of the loaded graphs and the road index, with one
+// overlay per profile. When an overlay has grown large all of them are folded
+// into new graphs, which also replace the snapshot so the next start sees the
+// updates.
+static void applyChangeFiles(std::vector<GraphOverlay>& overlays, const std::string& snapshot_file) {
+    const char* list = std::getenv("ROUTE_TRACER_CHANGES");
+    if (!list || !*list) return;
+
+    // the area the graphs were built from; updates must not grow past it
+    const Region region = Region::fromArray(graphs.region.data(), graphs.region.size());
+    std::stringstream files(list);
+    std::string osc_file;
+    while (std::getline(files, osc_file, ',')) {
+        if (osc_file.empty()) continue;
+        try {
+            auto start_time = std::chrono::steady_clock::now();
+            std::ostringstream per_profile;
+            for (GraphOverlay& overlay : overlays) {
+                GraphChangeSet changes = readOsmChange(osc_file, overlay, region);
+                overlay.apply(changes);
+                per_profile << "  " << profileName(overlay.base().profile) << ": " << changes.touched_ways.size()
+                            << " ways, " << overlay.pendingChanges() << " pending graph changes\n";
             }
-            path.push_back(start);
-            std::reverse(path.begin(), path.end());
-            std::cout << "Path found! Nodes explored: " << nodes_explored << "\n";
-            return path;
+            auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - start_time);
+            std::cout << "Applied " << osc_file << " in " << elapsed.count() << " ms\n" << per_profile.str();
+        } catch (const std::exception& e) {
+            std::cerr << "Error applying change file " << osc_file << ": " << e.what() << "\n";
+            continue;
         }
+        applyMapDataChanges(osc_file);
 
-        if (!adj.count(current)) continue;
-
-        for (const auto& edge : adj[current]) {
-            double tentative_gScore = gScore[current] + edge.weight;
-
-            if (!gScore.count(edge.to) || tentative_gScore < gScore[edge.to]) {
-                parent[edge.to] = current;
-                gScore[edge.to] = tentative_gScore;
-                fScore[edge.to] = tentative_gScore +
-                    haversine(nodes[edge.to].lat, nodes[edge.to].lon,
-                              nodes[goal].lat, nodes[goal].lon);
-
-                openSet.push({edge.to, fScore[edge.to]});
+        bool compact = false;
+        for (const GraphOverlay& overlay : overlays) {
+            compact = compact || overlay.shouldCompact();
+        }
+        if (compact) {
+            // compacted graphs own their nodes, so the set stops sharing them
+            for (std::size_t i = 0; i < overlays.size(); ++i) {
+                compactOverlay(overlays, i);
+            }
+            try {
+                writeSnapshot(graphs, snapshot_file);
+            } catch (const std::exception& e) {
+                std::cerr << "Could not write graph snapshot: " << e.what() << "\n";
             }
         }
     }
+}
 
-    std::cout << "No path found after exploring " << nodes_explored << " nodes.\n";
-    return {};
+// Travel time along a searched (not yet expanded) path, taking the quickest
+// edge between each pair of nodes
+template <typename Graph>
+static double pathTravelSeconds(const Graph& graph, const std::vector<uint32_t>& path) {
+    uint64_t total = 0;
+    for (size_t i = 0; i + 1 < path.size(); ++i) {
+        uint32_t best = std::numeric_limits<uint32_t>::max();
+        graph.forEachOutEdge(path[i], Metric::time, [&](uint32_t to, uint32_t time) {
+            if (to == path[i + 1]) best = std::min(best, time);
+        });
+        total += best;
+    }
+    return total / 10.0;
 }
 
-void aStar() {
-    const std::string map_file = "/home/kali/source/repos/route_tracer/data/karachi.osm.pbf";
-    loadKarachiMap(map_file);
+static Profile askProfile(const std::vector<Profile>& profiles) {
+    std::cout << "Travel by";
+    for (std::size_t i = 0; i < profiles.size(); ++i) {
+        std::cout << (i == 0 ? " (" : ", (") << i + 1 << ") " << profileName(profiles[i]);
+    }
+    std::cout << "? Enter a number: ";
+    std::size_t profile_choice = 1;
+    std::cin >> profile_choice;
+    if (profile_choice < 1 || profile_choice > profiles.size()) profile_choice = 1;
+    return profiles[profile_choice - 1];
+}
 
+// Asks for the endpoints and writes the route that search(start, goal, metric)
+// finds over the graph to a new output file. Works on GraphOverlay and
+// TiledGraph alike.
+template <typename Graph, typename Search>
+static void routeQuery(const Graph& graph, Profile profile, Search&& search) {
     std::cout << "Do you want to enter (1) node IDs or (2) coordinates? Enter 1 or 2: ";
     int mode = 1;
     std::cin >> mode;
 
-    int64_t start = 0, goal = 0;
+    std::cout << "Optimise for (1) distance or (2) travel time? Enter 1 or 2: ";
+    int metric_choice = 1;
+    std::cin >> metric_choice;
+    const Metric metric = metric_choice == 2 ? Metric::time : Metric::distance;
+
+    uint32_t start = 0, goal = 0;
 
     if (mode == 1) {
+        int64_t start_id = 0, goal_id = 0;
         std::cout << "Enter start node ID: ";
-        std::cin >> start;
+        std::cin >> start_id;
         std::cout << "Enter goal node ID: ";
-        std::cin >> goal;
+        std::cin >> goal_id;
+
+        start = graph.indexOf(start_id);
+        goal = graph.indexOf(goal_id);
+        if (start == NodeIdMap::invalid_index || goal == NodeIdMap::invalid_index) {
+            std::cerr << "Invalid node IDs (not found in loaded road graph).\n";
+            return;
+        }
+        // shape nodes of contracted chains have no edges of their own
+        if (!graph.hasEdges(start)) start = graph.nearestNode(graph.coord(start).lat, graph.coord(start).lon);
+        if (!graph.hasEdges(goal)) goal = graph.nearestNode(graph.coord(goal).lat, graph.coord(goal).lon);
     } else {
         double slat, slon, glat, glon;
         std::cout << "Enter start latitude: ";
@@ -239,18 +218,18 @@ void aStar() {
         std::cout << "Enter goal longitude: ";
         std::cin >> glon;
 
-        start = findNearestNode(slat, slon);
-        goal  = findNearestNode(glat, glon);
+        if (graph.numNodes() == 0) {
+            std::cerr << "Road graph is empty.\n";
+            return;
+        }
 
-        std::cout << "Nearest start node: " << start
-                  << "  (lat: " << nodes[start].lat << " lon: " << nodes[start].lon << ")\n";
-        std::cout << "Nearest goal node: " << goal
-                  << "  (lat: " << nodes[goal].lat << " lon: " << nodes[goal].lon << ")\n";
-    }
+        start = graph.nearestNode(slat, slon);
+        goal  = graph.nearestNode(glat, glon);
 
-    if (!nodes.count(start) || !nodes.count(goal)) {
-        std::cerr << "Invalid node IDs (not found in loaded OSM nodes).\n";
-        return;
+        std::cout << "Nearest start node: " << graph.osmId(start)
+                  << "  (lat: " << graph.coord(start).lat << " lon: " << graph.coord(start).lon << ")\n";
+        std::cout << "Nearest goal node: " << graph.osmId(goal)
+                  << "  (lat: " << graph.coord(goal).lat << " lon: " << graph.coord(goal).lon << ")\n";
     }
 
     // Generate output file name
@@ -266,19 +245,30 @@ void aStar() {
         return;
     }
 
-    double straight_distance = haversine(nodes[start].lat, nodes[start].lon,
-                                         nodes[goal].lat, nodes[goal].lon);
+    const Node start_node = graph.coord(start);
+    const Node goal_node = graph.coord(goal);
+    double straight_distance = haversine(start_node.lat, start_node.lon,
+                                         goal_node.lat, goal_node.lon);
     std::cout << "Straight-line distance: " << straight_distance / 1000.0 << " km\n";
 
     std::cout << "Calculating shortest path...\n";
     auto start_time = std::chrono::high_resolution_clock::now();
-    std::vector<int64_t> path = astar(start, goal);
+    std::vector<uint32_t> path;
+    if (!graph.mayReach(start, goal)) {
+        std::cout << "Start and goal lie in disconnected parts of the road network.\n";
+    } else {
+        path = search(start, goal, metric);
+    }
     auto end_time = std::chrono::high_resolution_clock::now();
+    const double travel_seconds = pathTravelSeconds(graph, path);
+    path = graph.expandPath(path, metric);
     auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time);
 
-    outfile << "Start Node ID: " << start << "\n";
-    outfile << "Goal Node ID: " << goal << "\n";
+    outfile << "Start Node ID: " << graph.osmId(start) << "\n";
+    outfile << "Goal Node ID: " << graph.osmId(goal) << "\n";
     outfile << "Straight-line distance: " << straight_distance / 1000.0 << " km\n";
+    outfile << "Profile: " << profileName(profile) << "\n";
+    outfile << "Optimised for: " << (metric == Metric::time ? "travel time" : "distance") << "\n";
     outfile << "Calculation time: " << duration.count() << " ms\n";
     outfile << "------------------------------------\n";
 
@@ -289,20 +279,23 @@ void aStar() {
         double total = 0;
         outfile << "Shortest path:\n";
         for (size_t i = 0; i < path.size(); ++i) {
-            outfile << path[i];
+            outfile << graph.osmId(path[i]);
             if (i + 1 < path.size()) {
-                double d = haversine(nodes[path[i]].lat, nodes[path[i]].lon,
-                                     nodes[path[i + 1]].lat, nodes[path[i + 1]].lon);
+                const Node a = graph.coord(path[i]);
+                const Node b = graph.coord(path[i + 1]);
+                double d = haversine(a.lat, a.lon, b.lat, b.lon);
                 total += d;
                 outfile << " -> ";
             }
         }
         outfile << "\nTotal distance: " << total / 1000.0 << " km\n";
+        outfile << "Estimated travel time: " << travel_seconds / 60.0 << " min\n";
         outfile << "Path length: " << path.size() << " nodes\n";
         outfile << "Efficiency ratio: " << (straight_distance > 0 ? (total / straight_distance) : 0.0) << " (ideal: ~1.0)\n";
 
         std::cout << "Path saved successfully to: " << filename.str() << "\n";
         std::cout << "Total distance: " << total / 1000.0 << " km\n";
+        std::cout << "Estimated travel time: " << travel_seconds / 60.0 << " min\n";
         std::cout << "Efficiency ratio: " << (straight_distance > 0 ? (total / straight_distance) : 0.0) << " (ideal: ~1.0)\n";
 
         if (total / straight_distance > 1.3) {
@@ -312,4 +305,84 @@ void aStar() {
     }
 
     outfile.close();
-}
\ No newline at end of file
+}
+
+// With ROUTE_TRACER_TILE_CACHE_MB set, routes over the snapshot tile by tile
+// within that much memory instead of mapping it whole. Change files are not
+// applied in that mode. Returns false if the snapshot cannot be read that way.
+static bool tiledQuery(const std::string& snapshot_file) {
+    const char* cache_mb = std::getenv("ROUTE_TRACER_TILE_CACHE_MB");
+    if (!cache_mb || !*cache_mb) return false;
+    const std::size_t memory_cap = static_cast<std::size_t>(std::strtoull(cache_mb, nullptr, 10)) << 20;
+
+    std::unique_ptr<TiledGraph> graph;
+    try {
+        const Profile profile = askProfile(readSnapshotLayout(snapshot_file).profiles);
+        graph = std::make_unique<TiledGraph>(snapshot_file, profile, memory_cap);
+    } catch (const std::exception& e) {
+        std::cout << "Cannot route tile by tile (" << e.what() << "), mapping the whole graph\n";
+        return false;
+    }
+    std::cout << "Routing over " << graph->numTiles() << " tiles with a " << cache_mb << " MB tile cache. Road nodes: "
+              << graph->numNodes() << "  Edges: " << graph->numEdges() << "\n";
+    if (graph->hasTurnRestrictions()) {
+        std::cout << "Turn restrictions are not applied when routing tile by tile.\n";
+    }
+
+    try {
+        routeQuery(*graph, graph->profile(), [&graph](uint32_t start, uint32_t goal, Metric metric) {
+            return astar(*graph, start, goal, metric);
+        });
+    } catch (const std::exception& e) {
+        std::cerr << "Error reading graph tiles: " << e.what() << "\n";
+    }
+    const TiledGraph::CacheStats& stats = graph->cacheStats();
+    std::cout << "Tiles loaded: " << stats.loads << "  Evicted: " << stats.evictions
+              << "  Peak tile memory: " << stats.peak_bytes / 1024 << " KB\n";
+    return true;
+}
+
+void aStar() {
+    const std::string map_file = "/home/kali/source/repos/route_tracer/data/karachi.osm.pbf";
+    const std::string snapshot_file = "/home/kali/source/repos/route_tracer/data/karachi.graph";
+    if (tiledQuery(snapshot_file)) return;
+    loadKarachiMap(map_file, snapshot_file);
+    if (graphs.graphs.empty()) return;
+
+    std::vector<GraphOverlay> overlays;
+    std::vector<Profile> profiles;
+    for (const RoadGraph& g : graphs.graphs) {
+        overlays.emplace_back(g);
+        profiles.push_back(g.profile);
+    }
+    applyChangeFiles(overlays, snapshot_file);
+
+    const Profile profile = askProfile(profiles);
+    const std::size_t slot = static_cast<std::size_t>(std::find(profiles.begin(), profiles.end(), profile) - profiles.begin());
+    if (overlays[slot].changesTurns()) {
+        // the base turn table knows nothing about the added edges
+        compactOverlay(overlays, slot);
+    }
+    const RoadGraph& graph = graphs.graphs[slot];
+    const GraphOverlay& overlay = overlays[slot];
+
+    routeQuery(overlay, profile, [&graph, &overlay](uint32_t start, uint32_t goal, Metric metric) {
+        if (!graph.turns.empty()) {
+            return overlay.empty() ? astarWithTurns(graph, start, goal, metric)
+                                   : astarWithTurns(overlay, graph, start, goal, metric);
+        }
+        if (!overlay.empty()) {
+            return astar(overlay, start, goal, metric);
+        }
+        if (!graph.adjacency.empty()) {
+            return astar(CompressedGraph(graph), start, goal, metric);
+        }
+        if (!graph.landmarks.empty()) {
+            return altAstar(graph, start, goal, metric);
+        }
+        if (!graph.reverse.empty()) {
+            return bidirectionalAstar(graph, start, goal, metric);
+        }
+        return astar(graph, start, goal, metric);
+    });
+}
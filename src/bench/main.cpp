@@ -0,0 +1,215 @@
+// route_tracer_bench: query benchmarks on a graph snapshot. Not part of the
+// test suite; run it by hand on a quiet machine, e.g.
+//   route_tracer_bench data/karachi.graph --queries 2000
+//
+// Node order: the snapshot is renumbered in OSM id, BFS and Hilbert order and
+// the same random queries run on each copy. Reports time, settled nodes and
+// cache misses per settled node (perf_event_open; "n/a" when the kernel does
+// not allow it).
+//
+// Adjacency: the Hilbert-ordered copy is searched once more through its
+// delta/varint compressed edges, and the memory of both edge encodings is
+// printed next to the query times.
+//
+// Search: the Hilbert-ordered queries also run bidirectionally and with the
+// ALT heuristic over 16 landmarks (--landmarks N to change).
+//
+// Open set: the Hilbert-ordered queries run again with the lazy-deletion
+// binary heap (the std::priority_queue the search used to have), the radix
+// heap and Dial's bucket queue in place of the default indexed 4-ary heap.
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "components.hpp"
+#include "graph_snapshot.hpp"
+#include "node_order.hpp"
+#include "parallel.hpp"
+#include "perf_counter.hpp"
+#include "search.hpp"
+
+struct BenchOptions {
+    std::string snapshot_file;
+    uint32_t queries = 1000;
+    uint32_t seed = 42;
+    Metric metric = Metric::distance;
+    Profile profile = Profile::car;
+    uint32_t landmarks = 16;
+};
+
+// Query endpoints as OSM ids, so they mean the same on every renumbered copy
+static std::vector<std::pair<int64_t, int64_t>> pickQueries(const RoadGraph& g, const BenchOptions& options) {
+    std::vector<uint32_t> candidates;
+    for (uint32_t v = 0; v < g.numNodes(); ++v) {
+        // stay inside the giant component so every query finds a path
+        bool usable = g.component.empty() ? g.first_out[v] != g.first_out[v + 1] : g.component[v] == 0;
+        if (usable) candidates.push_back(v);
+    }
+    std::vector<std::pair<int64_t, int64_t>> queries;
+    if (candidates.empty()) return queries;
+    std::mt19937 rng(options.seed);
+    std::uniform_int_distribution<std::size_t> pick(0, candidates.size() - 1);
+    for (uint32_t i = 0; i < options.queries; ++i) {
+        queries.push_back({g.osmId(candidates[pick(rng)]), g.osmId(candidates[pick(rng)])});
+    }
+    return queries;
+}
+
+static void printMisses(const char* label, const PerfCounter& counter, uint64_t misses, uint64_t settled) {
+    std::cout << "  " << std::setw(18) << std::left << label;
+    if (counter.available() && settled > 0) {
+        std::cout << std::fixed << std::setprecision(2) << double(misses) / settled << " per settled node\n";
+    } else {
+        std::cout << "n/a\n";
+    }
+}
+
+// search(s, t, metric, stats) on graph with Queue as open set; graph must
+// outlive it
+template <typename Queue = DefaultSearchQueue, typename Graph>
+static auto astarOn(const Graph& graph) {
+    return [&graph](uint32_t s, uint32_t t, Metric metric, SearchStats* stats) {
+        return astar<Queue>(graph, s, t, metric, stats);
+    };
+}
+
+// g supplies the node ids; search(s, t, metric, stats) runs the queries
+template <typename Search>
+static void runQueries(const std::string& name, const RoadGraph& g,
+                       const std::vector<std::pair<int64_t, int64_t>>& queries, Metric metric, Search&& search) {
+    PerfCounter l1_misses(PERF_TYPE_HW_CACHE, cacheReadMisses(PERF_COUNT_HW_CACHE_L1D));
+    PerfCounter llc_misses(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+
+    // astar() reports every query on stdout
+    std::ostringstream discard;
+    std::streambuf* saved = std::cout.rdbuf(discard.rdbuf());
+
+    uint64_t settled = 0;
+    uint64_t l1 = 0, llc = 0;
+    auto start_time = std::chrono::steady_clock::now();
+    for (const auto& q : queries) {
+        const uint32_t s = g.node_ids.indexOf(q.first);
+        const uint32_t t = g.node_ids.indexOf(q.second);
+        SearchStats stats;
+        l1_misses.start();
+        llc_misses.start();
+        search(s, t, metric, &stats);
+        llc += llc_misses.stop();
+        l1 += l1_misses.stop();
+        settled += stats.settled;
+        discard.str("");
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start_time);
+    std::cout.rdbuf(saved);
+
+    std::cout << name << ": " << elapsed.count() / 1000.0 / queries.size() << " ms/query, "
+              << settled / queries.size() << " settled nodes/query\n";
+    printMisses("L1d read misses:", l1_misses, l1, settled);
+    printMisses("LLC misses:", llc_misses, llc, settled);
+}
+
+static void printUsage(const char* program) {
+    std::cerr << "Usage: " << program << " GRAPH.graph [options]\n"
+              << "  --queries N          random queries per run (default: 1000)\n"
+              << "  --seed N             query generator seed (default: 42)\n"
+              << "  --metric NAME        distance or time (default: distance)\n"
+              << "  --profile NAME       car, bike or foot (default: car)\n"
+              << "  --landmarks N        landmarks for the ALT run, 8 to 32 (default: 16)\n";
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    BenchOptions options;
+    options.snapshot_file = argv[1];
+    for (int i = 2; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const bool has_value = i + 1 < argc;
+        if (arg == "--queries" && has_value) {
+            options.queries = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--seed" && has_value) {
+            options.seed = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--metric" && has_value) {
+            options.metric = std::string(argv[++i]) == "time" ? Metric::time : Metric::distance;
+        } else if (arg == "--landmarks" && has_value) {
+            options.landmarks = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--profile" && has_value) {
+            try {
+                options.profile = parseProfile(argv[++i]);
+            } catch (const std::invalid_argument& e) {
+                std::cerr << e.what() << "\n";
+                return 1;
+            }
+        } else {
+            std::cerr << "Unknown option: " << arg << "\n";
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    try {
+        const GraphSet graphs = loadSnapshot(options.snapshot_file);
+        const RoadGraph* found = graphs.find(options.profile);
+        if (!found) {
+            std::cerr << "ERROR: snapshot has no " << profileName(options.profile) << " graph\n";
+            return 1;
+        }
+        const RoadGraph& graph = *found;
+        std::cout << "Profile: " << profileName(graph.profile) << "  Road nodes: " << graph.numNodes() << "  Edges: " << graph.numEdges() << "\n";
+        const auto queries = pickQueries(graph, options);
+        if (queries.empty()) {
+            std::cerr << "ERROR: graph has no routable nodes\n";
+            return 1;
+        }
+
+        // one renumbered copy at a time
+        {
+            const RoadGraph by_id = renumberNodes(graph, osmIdOrder(graph));
+            runQueries("osm_id order", by_id, queries, options.metric, astarOn(by_id));
+        }
+        {
+            const RoadGraph bfs = renumberNodes(graph, bfsOrder(graph));
+            runQueries("bfs order", bfs, queries, options.metric, astarOn(bfs));
+        }
+        RoadGraph hilbert = renumberNodes(graph, hilbertOrder(graph));
+        runQueries("hilbert order", hilbert, queries, options.metric, astarOn(hilbert));
+        runQueries("hilbert order, lazy heap", hilbert, queries, options.metric, astarOn<LazyBinaryHeap>(hilbert));
+        runQueries("hilbert order, radix heap", hilbert, queries, options.metric, astarOn<RadixHeap>(hilbert));
+        runQueries("hilbert order, dial buckets", hilbert, queries, options.metric, astarOn<DialQueue>(hilbert));
+
+        hilbert.reverse = buildReverseAdjacency(hilbert);
+        runQueries("hilbert order, bidirectional", hilbert, queries, options.metric,
+                   [&hilbert](uint32_t s, uint32_t t, Metric metric, SearchStats* stats) {
+                       return bidirectionalAstar(hilbert, s, t, metric, stats);
+                   });
+
+        hilbert.adjacency = compressAdjacency(hilbert);
+        const CompressedGraph compressed(hilbert);
+        runQueries("hilbert order, compressed", hilbert, queries, options.metric, astarOn(compressed));
+
+        hilbert.landmarks = buildLandmarks(hilbert, options.landmarks, resolveThreadCount(0));
+        runQueries("hilbert order, ALT", hilbert, queries, options.metric,
+                   [&hilbert](uint32_t s, uint32_t t, Metric metric, SearchStats* stats) {
+                       return altAstar(hilbert, s, t, metric, stats);
+                   });
+        const std::size_t csr_bytes = (hilbert.first_out.size() + 3 * std::size_t(hilbert.numEdges())) * sizeof(uint32_t);
+        std::cout << "Adjacency memory: " << csr_bytes / 1024 << " KB as CSR, "
+                  << hilbert.adjacency.memoryBytes() / 1024 << " KB compressed ("
+                  << std::fixed << std::setprecision(2) << double(hilbert.adjacency.bytes.size()) / hilbert.numEdges()
+                  << " bytes per edge)\n";
+    } catch (const std::exception& e) {
+        std::cerr << "ERROR: " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,193 @@
+// route_tracer_tag_bench: way tag classification on a real way stream. Not
+// part of the test suite; run it by hand on a quiet machine, e.g.
+//   route_tracer_tag_bench data/karachi.osm.pbf --rounds 20
+//
+// All ways of the input are read into memory first, then each round
+// classifies every way for the car profile twice: with the string-set rules
+// the loader used before (kept here as the reference) and with classifyWay()
+// plus the per-profile rules. A third run evaluates all profiles from one
+// classifyWay() call, as the graph builder does.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <osmium/io/any_input.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/way.hpp>
+
+#include "road_ways.hpp"
+#include "way_tags.hpp"
+
+// The car rules as the loader implemented them with std::string lookups
+static WayDirection referenceCarDirection(const osmium::Way& way) {
+    static const std::unordered_set<std::string> drivables = {
+        "motorway","trunk","primary","secondary","tertiary",
+        "unclassified","residential","service","living_street",
+        "motorway_link","primary_link","secondary_link","tertiary_link"
+    };
+    static const std::unordered_set<std::string> nondrivable = {
+        "footway","path","cycleway","steps","pedestrian","track","bridleway","corridor"
+    };
+
+    const char* highway_tag = way.tags()["highway"];
+    if (!highway_tag) return WayDirection::none;
+    std::string hw = highway_tag;
+    if (nondrivable.count(hw)) return WayDirection::none;
+    if (!drivables.count(hw)) return WayDirection::none;
+
+    const char* access_tag = way.tags()["access"];
+    const char* motor_tag = way.tags()["motor_vehicle"];
+    if ((access_tag && std::string(access_tag) == "no") ||
+        (motor_tag && std::string(motor_tag) == "no")) {
+        return WayDirection::none;
+    }
+
+    bool oneway = false;
+    bool oneway_reverse = false;
+    const char* oneway_tag = way.tags()["oneway"];
+    const char* junction_tag = way.tags()["junction"];
+    if (junction_tag && std::string(junction_tag) == "roundabout") {
+        oneway = true;
+    }
+    if (oneway_tag) {
+        std::string ow(oneway_tag);
+        if (ow == "yes" || ow == "true" || ow == "1") oneway = true;
+        else if (ow == "-1") oneway_reverse = true;
+    }
+
+    if (oneway_reverse) return WayDirection::backward;
+    if (oneway) return WayDirection::forward;
+    return WayDirection::both;
+}
+
+static double referenceCarSpeedKmh(const osmium::Way& way) {
+    static const std::unordered_map<std::string, double> default_speeds = {
+        {"motorway", 90}, {"motorway_link", 45},
+        {"trunk", 85}, {"trunk_link", 40},
+        {"primary", 65}, {"primary_link", 30},
+        {"secondary", 55}, {"secondary_link", 25},
+        {"tertiary", 40}, {"tertiary_link", 20},
+        {"unclassified", 25}, {"residential", 25},
+        {"living_street", 10}, {"service", 15}
+    };
+
+    double speed = 25;
+    const char* highway_tag = way.tags()["highway"];
+    if (highway_tag) {
+        auto it = default_speeds.find(highway_tag);
+        if (it != default_speeds.end()) speed = it->second;
+    }
+    const char* maxspeed_tag = way.tags()["maxspeed"];
+    if (maxspeed_tag) {
+        char* end = nullptr;
+        double value = std::strtod(maxspeed_tag, &end);
+        if (end != maxspeed_tag && value > 0) {
+            if (std::strstr(end, "mph")) value *= 1.609344;
+            speed = value;
+        }
+    }
+    return std::min(std::max(speed, 5.0), max_road_speed_kmh);
+}
+
+// classify is called on every way; callers fold results into a checksum so
+// the work cannot be optimised away
+template <typename F>
+static double timeRounds(const std::vector<const osmium::Way*>& ways, unsigned rounds, F&& classify) {
+    auto start_time = std::chrono::steady_clock::now();
+    for (unsigned r = 0; r < rounds; ++r) {
+        for (const osmium::Way* way : ways) {
+            classify(*way);
+        }
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start_time);
+    return double(elapsed.count()) / (double(ways.size()) * rounds);
+}
+
+static void printUsage(const char* program) {
+    std::cerr << "Usage: " << program << " INPUT.osm.pbf [options]\n"
+              << "  --rounds N           passes over all ways (default: 10)\n";
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    const std::string input_file = argv[1];
+    unsigned rounds = 10;
+    for (int i = 2; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--rounds" && i + 1 < argc) {
+            rounds = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        } else {
+            std::cerr << "Unknown option: " << arg << "\n";
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+    if (rounds == 0) rounds = 1;
+
+    try {
+        std::vector<osmium::memory::Buffer> buffers;
+        std::vector<const osmium::Way*> ways;
+        osmium::io::Reader reader(input_file, osmium::osm_entity_bits::way, osmium::io::read_meta::no);
+        while (osmium::memory::Buffer buffer = reader.read()) {
+            buffers.push_back(std::move(buffer));
+        }
+        reader.close();
+        for (const auto& buffer : buffers) {
+            for (const auto& way : buffer.select<osmium::Way>()) {
+                ways.push_back(&way);
+            }
+        }
+        if (ways.empty()) {
+            std::cerr << "ERROR: no ways in " << input_file << "\n";
+            return 1;
+        }
+        std::cout << "Ways: " << ways.size() << "  Rounds: " << rounds << "\n";
+
+        uint64_t checksum = 0;
+        const double reference_ns = timeRounds(ways, rounds, [&checksum](const osmium::Way& way) {
+            WayDirection dir = referenceCarDirection(way);
+            if (dir != WayDirection::none) checksum += static_cast<uint64_t>(referenceCarSpeedKmh(way));
+        });
+        const double classified_ns = timeRounds(ways, rounds, [&checksum](const osmium::Way& way) {
+            const WayAttributes attributes = classifyWay(way.tags());
+            WayDirection dir = roadDirection(attributes, Profile::car);
+            if (dir != WayDirection::none) checksum += static_cast<uint64_t>(roadSpeedKmh(attributes, Profile::car));
+        });
+        const double all_profiles_ns = timeRounds(ways, rounds, [&checksum](const osmium::Way& way) {
+            const WayAttributes attributes = classifyWay(way.tags());
+            for (Profile p : {Profile::car, Profile::bike, Profile::foot}) {
+                if (roadDirection(attributes, p) != WayDirection::none) {
+                    checksum += static_cast<uint64_t>(roadSpeedKmh(attributes, p));
+                }
+            }
+        });
+
+        // both car classifiers must agree way by way
+        std::size_t mismatches = 0;
+        for (const osmium::Way* way : ways) {
+            if (referenceCarDirection(*way) != roadDirection(*way, Profile::car)) ++mismatches;
+        }
+
+        std::cout << "string sets (car):          " << reference_ns << " ns/way\n"
+                  << "classifyWay (car):          " << classified_ns << " ns/way ("
+                  << reference_ns / classified_ns << "x)\n"
+                  << "classifyWay (all profiles): " << all_profiles_ns << " ns/way\n"
+                  << "Direction mismatches: " << mismatches << "  (checksum " << checksum << ")\n";
+        if (mismatches > 0) return 1;
+    } catch (const std::exception& e) {
+        std::cerr << "ERROR: " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
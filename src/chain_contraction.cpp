@@ -0,0 +1,177 @@
+#include "chain_contraction.hpp"
+
+#include <utility>
+
+// Up to two predecessors per node, which is all the contraction test needs
+struct InEdges {
+    uint32_t count = 0;
+    uint32_t from[2];
+    uint32_t way[2];
+};
+
+static std::vector<InEdges> collectInEdges(const RoadGraph& g) {
+    std::vector<InEdges> in(g.numNodes());
+    for (uint32_t u = 0; u < g.numNodes(); ++u) {
+        for (uint32_t e = g.first_out[u]; e < g.first_out[u + 1]; ++e) {
+            InEdges& entry = in[g.head[e]];
+            if (entry.count < 2) {
+                entry.from[entry.count] = u;
+                entry.way[entry.count] = g.edge_way[e];
+            }
+            entry.count++;
+        }
+    }
+    return in;
+}
+
+static bool isChainNode(const RoadGraph& g, const InEdges& in, uint32_t v) {
+    const uint32_t e = g.first_out[v];
+    const uint32_t out_degree = g.first_out[v + 1] - e;
+
+    if (out_degree == 1 && in.count == 1) {
+        // one-way: a -> v -> b
+        const uint32_t a = in.from[0], b = g.head[e];
+        return a != v && b != v && a != b && in.way[0] == g.edge_way[e];
+    }
+    if (out_degree == 2 && in.count == 2) {
+        // two-way: a <-> v <-> b
+        const uint32_t a = g.head[e], b = g.head[e + 1];
+        const uint32_t way = g.edge_way[e];
+        return a != v && b != v && a != b && g.edge_way[e + 1] == way &&
+               in.way[0] == way && in.way[1] == way &&
+               ((in.from[0] == a && in.from[1] == b) || (in.from[0] == b && in.from[1] == a));
+    }
+    return false;
+}
+
+RoadGraph contractChains(RoadGraph g) {
+    const uint32_t n = g.numNodes();
+    const bool has_geometry = !g.geometry_first.empty();
+
+    std::vector<bool> chain(n, false);
+    {
+        const std::vector<InEdges> in = collectInEdges(g);
+        for (uint32_t v = 0; v < n; ++v) {
+            chain[v] = isChainNode(g, in[v], v);
+        }
+    }
+
+    // Follows edge e from its source through chain nodes to the next junction.
+    // Calls on_edge(e) and on_shape(v) for every edge and chain node passed, in
+    // travel order, and returns the junction.
+    auto walk = [&](uint32_t source, uint32_t e, auto&& on_edge, auto&& on_shape) {
+        uint32_t prev = source;
+        uint32_t cur = g.head[e];
+        on_edge(e);
+        while (chain[cur] && cur != source) {
+            on_shape(cur);
+            uint32_t next = g.first_out[cur];
+            if (g.first_out[cur + 1] - next == 2 && g.head[next] == prev) next++;
+            on_edge(next);
+            prev = cur;
+            cur = g.head[next];
+        }
+        return cur;
+    };
+
+    // A chain that leads back to its start would become a self-loop, which no
+    // shortest path uses, and its nodes could no longer be routed to. Keeping
+    // its middle node splits it into two edges. Rings made only of chain nodes
+    // are never reached from a junction, so one of their nodes is kept first.
+    {
+        std::vector<bool> reached(n, false);
+        std::vector<uint32_t> shapes;
+        auto ignore = [](uint32_t) {};
+        auto record = [&](uint32_t v) {
+            reached[v] = true;
+            shapes.push_back(v);
+        };
+        auto splitLoops = [&](uint32_t u) {
+            for (uint32_t e = g.first_out[u]; e < g.first_out[u + 1]; ++e) {
+                shapes.clear();
+                if (walk(u, e, ignore, record) == u && !shapes.empty()) {
+                    chain[shapes[shapes.size() / 2]] = false;
+                }
+            }
+        };
+        for (uint32_t u = 0; u < n; ++u) {
+            if (!chain[u]) splitLoops(u);
+        }
+        for (uint32_t u = 0; u < n; ++u) {
+            if (chain[u] && !reached[u]) {
+                chain[u] = false;
+                splitLoops(u);
+            }
+        }
+    }
+
+    std::vector<uint32_t> first_out(n + 1, 0);
+    std::vector<uint32_t> head, edge_way, geometry_first, geometry;
+    std::vector<uint32_t> length, travel_time;
+    geometry_first.push_back(0);
+
+    for (uint32_t u = 0; u < n; ++u) {
+        first_out[u] = static_cast<uint32_t>(head.size());
+        if (chain[u]) continue;
+        for (uint32_t e = g.first_out[u]; e < g.first_out[u + 1]; ++e) {
+            const std::size_t shapes_begin = geometry.size();
+            EdgeCost cost{0, 0};
+            auto addEdge = [&](uint32_t step) {
+                cost.length += g.length[step];
+                cost.time += g.travel_time[step];
+                if (has_geometry) {
+                    for (uint32_t i = g.geometry_first[step]; i < g.geometry_first[step + 1]; ++i) {
+                        geometry.push_back(g.geometry[i]);
+                    }
+                }
+            };
+            auto addShape = [&geometry](uint32_t v) { geometry.push_back(v); };
+            const uint32_t to = walk(u, e, addEdge, addShape);
+
+            if (to == u) {
+                geometry.resize(shapes_begin);
+                continue;
+            }
+            head.push_back(to);
+            length.push_back(cost.length);
+            travel_time.push_back(cost.time);
+            edge_way.push_back(g.edge_way[e]);
+            geometry_first.push_back(static_cast<uint32_t>(geometry.size()));
+        }
+    }
+    first_out[n] = static_cast<uint32_t>(head.size());
+
+    RoadGraph contracted;
+    contracted.first_out = std::move(first_out);
+    contracted.head = std::move(head);
+    contracted.length = std::move(length);
+    contracted.travel_time = std::move(travel_time);
+    contracted.edge_way = std::move(edge_way);
+    contracted.geometry_first = std::move(geometry_first);
+    contracted.geometry = std::move(geometry);
+    contracted.way_ids = std::move(g.way_ids);
+    contracted.coords = std::move(g.coords);
+    contracted.node_ids = std::move(g.node_ids);
+    contracted.profile = g.profile;
+    contracted.turn_restrictions = std::move(g.turn_restrictions);
+    contracted.storage = std::move(g.storage);
+    resolveTurnRestrictions(contracted);
+    return contracted;
+}
+
+std::vector<uint32_t> expandPath(const RoadGraph& g, const std::vector<uint32_t>& path, Metric metric) {
+    if (g.geometry_first.empty()) return path;
+
+    std::vector<uint32_t> full;
+    full.reserve(path.size());
+    for (std::size_t i = 0; i < path.size(); ++i) {
+        full.push_back(path[i]);
+        if (i + 1 == path.size()) break;
+        const uint32_t e = g.findEdge(path[i], path[i + 1], metric);
+        if (e == NodeIdMap::invalid_index) continue;
+        for (uint32_t s = g.geometry_first[e]; s < g.geometry_first[e + 1]; ++s) {
+            full.push_back(g.geometry[s]);
+        }
+    }
+    return full;
+}
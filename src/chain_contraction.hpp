@@ -0,0 +1,24 @@
+#ifndef CHAIN_CONTRACTION
+#define CHAIN_CONTRACTION
+
+#include <cstdint>
+#include <vector>
+
+#include "road_graph.hpp"
+
+// Collapses chains of degree-2 nodes into single edges. A node is contracted
+// when it only continues one way: either two-way with exactly two neighbours,
+// or one-way with one predecessor and one successor, and all of its edges
+// belong to the same way. The replacement edge carries the summed length and
+// lists the contracted nodes in its geometry range. Contracted nodes keep
+// their index, id and location but lose all edges, so the search never sees
+// them. Self-loops are dropped.
+RoadGraph contractChains(RoadGraph g);
+
+// Expands a path over a contracted graph into the full node sequence, adding
+// the shape nodes of the cheapest edge (by the metric the path was searched
+// with) between each pair of path nodes.
+std::vector<uint32_t> expandPath(const RoadGraph& g, const std::vector<uint32_t>& path,
+                                 Metric metric = Metric::distance);
+
+#endif
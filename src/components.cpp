@@ -0,0 +1,213 @@
+#include "components.hpp"
+
+#include <algorithm>
+#include <numeric>
+#include <utility>
+
+#include "road_graph.hpp"
+#include "spatial_index.hpp"
+
+// Tarjan's algorithm with an explicit call stack; road graphs are far too deep
+// for recursion. Components come out in reverse topological order: every
+// component reachable from C is finished before C.
+static std::vector<uint32_t> tarjan(const RoadGraph& g, uint32_t& count) {
+    const uint32_t n = g.numNodes();
+    const uint32_t unvisited = no_component;
+    std::vector<uint32_t> index(n, unvisited);
+    std::vector<uint32_t> low(n, 0);
+    std::vector<uint32_t> comp(n, no_component);
+    std::vector<bool> on_stack(n, false);
+    std::vector<uint32_t> stack;
+
+    struct Frame {
+        uint32_t v;
+        uint32_t next_edge;
+    };
+    std::vector<Frame> calls;
+
+    uint32_t next_index = 0;
+    count = 0;
+    auto visit = [&](uint32_t v) {
+        index[v] = low[v] = next_index++;
+        stack.push_back(v);
+        on_stack[v] = true;
+        calls.push_back({v, g.first_out[v]});
+    };
+
+    for (uint32_t root = 0; root < n; ++root) {
+        if (index[root] != unvisited) continue;
+        visit(root);
+        while (!calls.empty()) {
+            const uint32_t v = calls.back().v;
+            if (calls.back().next_edge < g.first_out[v + 1]) {
+                const uint32_t w = g.head[calls.back().next_edge++];
+                if (index[w] == unvisited) {
+                    visit(w);
+                } else if (on_stack[w]) {
+                    low[v] = std::min(low[v], index[w]);
+                }
+                continue;
+            }
+
+            if (low[v] == index[v]) {
+                uint32_t w;
+                do {
+                    w = stack.back();
+                    stack.pop_back();
+                    on_stack[w] = false;
+                    comp[w] = count;
+                } while (w != v);
+                count++;
+            }
+            calls.pop_back();
+            if (!calls.empty()) {
+                const uint32_t parent = calls.back().v;
+                low[parent] = std::min(low[parent], low[v]);
+            }
+        }
+    }
+    return comp;
+}
+
+void computeComponents(RoadGraph& g) {
+    const uint32_t n = g.numNodes();
+    uint32_t count = 0;
+    std::vector<uint32_t> comp = tarjan(g, count);
+
+    // nodes without edges (e.g. contracted shape nodes) are left out
+    const std::vector<bool> used = nodesWithEdges(g);
+    std::vector<uint32_t> size(count, 0);
+    for (uint32_t v = 0; v < n; ++v) {
+        if (used[v]) size[comp[v]]++;
+    }
+
+    // reaches giant: components finish before everything that can reach them,
+    // so one pass in finish order sees each successor's flag already set.
+    // reached from giant: the reverse order pushes the flag forward.
+    const uint32_t giant = count > 0 ? static_cast<uint32_t>(
+        std::max_element(size.begin(), size.end()) - size.begin()) : 0;
+    std::vector<uint32_t> first(count + 1, 0);
+    for (uint32_t v = 0; v < n; ++v) {
+        first[comp[v] + 1]++;
+    }
+    std::partial_sum(first.begin(), first.end(), first.begin());
+    std::vector<uint32_t> members(n);
+    {
+        std::vector<uint32_t> next(first.begin(), first.end() - 1);
+        for (uint32_t v = 0; v < n; ++v) {
+            members[next[comp[v]]++] = v;
+        }
+    }
+
+    std::vector<uint8_t> flags(count, 0);
+    if (count > 0) {
+        flags[giant] = component_reaches_giant | component_reached_from_giant;
+    }
+    for (uint32_t c = 0; c < count; ++c) {
+        if (flags[c] & component_reaches_giant) continue;
+        for (uint32_t i = first[c]; i < first[c + 1] && !(flags[c] & component_reaches_giant); ++i) {
+            const uint32_t v = members[i];
+            for (uint32_t e = g.first_out[v]; e < g.first_out[v + 1]; ++e) {
+                if (flags[comp[g.head[e]]] & component_reaches_giant) {
+                    flags[c] |= component_reaches_giant;
+                    break;
+                }
+            }
+        }
+    }
+    for (uint32_t c = count; c-- > 0;) {
+        if (!(flags[c] & component_reached_from_giant)) continue;
+        for (uint32_t i = first[c]; i < first[c + 1]; ++i) {
+            const uint32_t v = members[i];
+            for (uint32_t e = g.first_out[v]; e < g.first_out[v + 1]; ++e) {
+                flags[comp[g.head[e]]] |= component_reached_from_giant;
+            }
+        }
+    }
+
+    // renumber by decreasing size, dropping the components of unused nodes
+    std::vector<uint32_t> order(count);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&size](uint32_t a, uint32_t b) { return size[a] > size[b]; });
+    std::vector<uint32_t> rank(count, no_component);
+    std::vector<uint8_t> ranked_flags;
+    for (uint32_t c : order) {
+        if (size[c] == 0) break;
+        rank[c] = static_cast<uint32_t>(ranked_flags.size());
+        ranked_flags.push_back(flags[c]);
+    }
+    for (uint32_t v = 0; v < n; ++v) {
+        comp[v] = used[v] ? rank[comp[v]] : no_component;
+    }
+
+    g.component = std::move(comp);
+    g.component_flags = std::move(ranked_flags);
+}
+
+RoadGraph pruneSmallComponents(RoadGraph g, uint32_t min_size) {
+    if (g.component.empty()) computeComponents(g);
+    const uint32_t n = g.numNodes();
+    const bool has_geometry = !g.geometry_first.empty();
+
+    std::vector<uint32_t> size(g.component_flags.size(), 0);
+    for (uint32_t v = 0; v < n; ++v) {
+        if (g.component[v] != no_component) size[g.component[v]]++;
+    }
+    auto keep = [&](uint32_t v) { return g.component[v] != no_component && size[g.component[v]] >= min_size; };
+
+    std::vector<uint32_t> first_out(n + 1, 0);
+    std::vector<uint32_t> head, edge_way, geometry_first, geometry;
+    std::vector<uint32_t> length, travel_time;
+    if (has_geometry) geometry_first.push_back(0);
+    for (uint32_t u = 0; u < n; ++u) {
+        first_out[u] = static_cast<uint32_t>(head.size());
+        if (!keep(u)) continue;
+        for (uint32_t e = g.first_out[u]; e < g.first_out[u + 1]; ++e) {
+            // edges between components stay as long as both ends are kept
+            if (!keep(g.head[e])) continue;
+            head.push_back(g.head[e]);
+            length.push_back(g.length[e]);
+            travel_time.push_back(g.travel_time[e]);
+            edge_way.push_back(g.edge_way[e]);
+            if (has_geometry) {
+                geometry.insert(geometry.end(), g.geometry.begin() + g.geometry_first[e],
+                                g.geometry.begin() + g.geometry_first[e + 1]);
+                geometry_first.push_back(static_cast<uint32_t>(geometry.size()));
+            }
+        }
+    }
+    first_out[n] = static_cast<uint32_t>(head.size());
+
+    RoadGraph pruned;
+    pruned.first_out = std::move(first_out);
+    pruned.head = std::move(head);
+    pruned.length = std::move(length);
+    pruned.travel_time = std::move(travel_time);
+    pruned.edge_way = std::move(edge_way);
+    pruned.geometry_first = std::move(geometry_first);
+    pruned.geometry = std::move(geometry);
+    pruned.way_ids = std::move(g.way_ids);
+    pruned.coords = std::move(g.coords);
+    pruned.node_ids = std::move(g.node_ids);
+    pruned.profile = g.profile;
+    pruned.turn_restrictions = std::move(g.turn_restrictions);
+    pruned.storage = std::move(g.storage);
+    computeComponents(pruned);
+    resolveTurnRestrictions(pruned);
+    return pruned;
+}
+
+bool mayReach(const RoadGraph& g, uint32_t s, uint32_t t) {
+    if (s == t || g.component.empty()) return true;
+    const uint32_t cs = g.component[s];
+    const uint32_t ct = g.component[t];
+    if (cs == no_component || ct == no_component) return false;
+    if (cs == ct) return true;
+
+    const uint8_t fs = g.component_flags[cs];
+    const uint8_t ft = g.component_flags[ct];
+    if (ct == 0) return fs & component_reaches_giant;
+    if (cs == 0) return ft & component_reached_from_giant;
+    // both outside the giant component; a path between them may still avoid it
+    return true;
+}
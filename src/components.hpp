@@ -0,0 +1,33 @@
+#ifndef COMPONENTS
+#define COMPONENTS
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+struct RoadGraph;
+
+// Component ids are numbered by size, so component 0 is the giant component
+// that normally holds almost the whole road network. Nodes without edges
+// belong to no component.
+constexpr uint32_t no_component = std::numeric_limits<uint32_t>::max();
+
+// Per-component flags, relative to the giant component
+enum : uint8_t {
+    component_reaches_giant = 1,     // some path leads into component 0
+    component_reached_from_giant = 2 // some path leads here from component 0
+};
+
+// Strongly connected components of g (iterative Tarjan), stored in
+// g.component and g.component_flags.
+void computeComponents(RoadGraph& g);
+
+// Removes the edges of every node whose strongly connected component has
+// fewer than min_size nodes, then recomputes the components.
+RoadGraph pruneSmallComponents(RoadGraph g, uint32_t min_size);
+
+// false only if no path from s to t can exist. Decided from the component
+// ids alone, so it is exact whenever s or t lies in the giant component.
+bool mayReach(const RoadGraph& g, uint32_t s, uint32_t t);
+
+#endif
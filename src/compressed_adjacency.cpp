@@ -0,0 +1,44 @@
+#include "compressed_adjacency.hpp"
+
+#include <limits>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "road_graph.hpp"
+
+static void writeVarint(std::vector<uint8_t>& out, uint32_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+CompressedAdjacency compressAdjacency(const RoadGraph& g) {
+    const uint32_t n = g.numNodes();
+    std::vector<uint32_t> first_byte(n + 1, 0);
+    std::vector<uint8_t> bytes;
+    bytes.reserve(std::size_t(g.numEdges()) * 5);
+    for (uint32_t v = 0; v < n; ++v) {
+        first_byte[v] = static_cast<uint32_t>(bytes.size());
+        uint32_t previous = v;
+        for (uint32_t e = g.first_out[v]; e < g.first_out[v + 1]; ++e) {
+            const int32_t delta = static_cast<int32_t>(g.head[e] - previous);
+            writeVarint(bytes, (static_cast<uint32_t>(delta) << 1) ^ static_cast<uint32_t>(delta >> 31));
+            writeVarint(bytes, g.length[e]);
+            writeVarint(bytes, g.travel_time[e]);
+            previous = g.head[e];
+        }
+        if (bytes.size() > std::numeric_limits<uint32_t>::max()) {
+            throw std::runtime_error("adjacency too large to compress with 32-bit offsets");
+        }
+    }
+    first_byte[n] = static_cast<uint32_t>(bytes.size());
+    bytes.shrink_to_fit();
+
+    CompressedAdjacency adjacency;
+    adjacency.first_byte = std::move(first_byte);
+    adjacency.bytes = std::move(bytes);
+    return adjacency;
+}
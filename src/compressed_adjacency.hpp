@@ -0,0 +1,54 @@
+#ifndef COMPRESSED_ADJACENCY
+#define COMPRESSED_ADJACENCY
+
+#include <cstddef>
+#include <cstdint>
+
+#include "graph_array.hpp"
+
+struct RoadGraph;
+
+// Out-edges of every node packed into one byte stream, an optional smaller
+// stand-in for head, length and travel_time when searching. The edges of node
+// v lie in bytes[first_byte[v] .. first_byte[v + 1] - 1], in the order of the
+// CSR arrays, each as three LEB128 varints: the target as a zigzag delta from
+// the previous target (from v for the first edge), the length and the travel
+// time. Once renumberNodes() has put neighbours close together most targets
+// fit in a byte or two, and an edge takes about 5 bytes instead of 12.
+struct CompressedAdjacency {
+    GraphArray<uint32_t> first_byte; // numNodes() + 1 offsets into bytes
+    GraphArray<uint8_t> bytes;
+
+    bool empty() const { return first_byte.empty(); }
+
+    std::size_t memoryBytes() const { return first_byte.size() * sizeof(uint32_t) + bytes.size(); }
+
+    // f(to, length, time) for every out-edge of v
+    template <typename F>
+    void decode(uint32_t v, F&& f) const {
+        const uint8_t* p = bytes.data() + first_byte[v];
+        const uint8_t* end = bytes.data() + first_byte[v + 1];
+        uint32_t to = v;
+        while (p < end) {
+            const uint32_t delta = readVarint(p);
+            to += (delta >> 1) ^ (0u - (delta & 1));
+            const uint32_t length = readVarint(p);
+            const uint32_t time = readVarint(p);
+            f(to, length, time);
+        }
+    }
+
+    static uint32_t readVarint(const uint8_t*& p) {
+        uint32_t value = *p & 0x7f;
+        for (unsigned shift = 7; *p++ & 0x80; shift += 7) {
+            value |= uint32_t(*p & 0x7f) << shift;
+        }
+        return value;
+    }
+};
+
+// Encodes the edges of g. Throws std::runtime_error if the stream would not
+// fit 32-bit offsets.
+CompressedAdjacency compressAdjacency(const RoadGraph& g);
+
+#endif
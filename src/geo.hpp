@@ -0,0 +1,21 @@
+#ifndef GEO
+#define GEO
+
+#include <cmath>
+
+constexpr double PI_CONST = 3.14159265358979323846;
+inline double deg2rad(double deg) { return deg * PI_CONST / 180.0; }
+
+inline double haversine(double lat1, double lon1, double lat2, double lon2) {
+    // Returns distance in meters
+    const double R = 6371000.0; // mean Earth radius in meters
+    double dLat = deg2rad(lat2 - lat1);
+    double dLon = deg2rad(lon2 - lon1);
+    double a = std::sin(dLat / 2.0) * std::sin(dLat / 2.0) +
+               std::cos(deg2rad(lat1)) * std::cos(deg2rad(lat2)) *
+               std::sin(dLon / 2.0) * std::sin(dLon / 2.0);
+    double c = 2.0 * std::atan2(std::sqrt(a), std::sqrt(1.0 - a));
+    return R * c;
+}
+
+#endif
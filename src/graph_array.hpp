@@ -0,0 +1,71 @@
+#ifndef GRAPH_ARRAY
+#define GRAPH_ARRAY
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+// Read-only array used for the frozen graph. It either owns its elements (graph
+// built in memory) or points into memory owned elsewhere, such as a mapped
+// snapshot file, so both cases are read through the same type.
+template <typename T>
+class GraphArray {
+public:
+    GraphArray() = default;
+
+    GraphArray(std::vector<T> values)
+        : m_owned(std::move(values)), m_data(m_owned.data()), m_size(m_owned.size()) {}
+
+    // Borrowed view; the caller keeps the memory alive
+    static GraphArray view(const T* data, std::size_t size) {
+        GraphArray a;
+        a.m_data = data;
+        a.m_size = size;
+        a.m_borrowed = true;
+        return a;
+    }
+
+    GraphArray(const GraphArray& other)
+        : m_owned(other.m_owned), m_data(other.m_borrowed ? other.m_data : m_owned.data()),
+          m_size(other.m_size), m_borrowed(other.m_borrowed) {}
+
+    GraphArray(GraphArray&& other) noexcept
+        : m_owned(std::move(other.m_owned)), m_data(other.m_data),
+          m_size(other.m_size), m_borrowed(other.m_borrowed) {
+        other.reset();
+    }
+
+    GraphArray& operator=(GraphArray other) noexcept {
+        // moving a vector keeps its buffer, so an owned m_data stays valid
+        m_owned = std::move(other.m_owned);
+        m_data = other.m_data;
+        m_size = other.m_size;
+        m_borrowed = other.m_borrowed;
+        other.reset();
+        return *this;
+    }
+
+    std::size_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+    bool borrowed() const { return m_borrowed; }
+
+    const T* data() const { return m_data; }
+    const T& operator[](std::size_t i) const { return m_data[i]; }
+    const T* begin() const { return m_data; }
+    const T* end() const { return m_data + m_size; }
+
+private:
+    void reset() {
+        m_owned.clear();
+        m_data = nullptr;
+        m_size = 0;
+        m_borrowed = false;
+    }
+
+    std::vector<T> m_owned;
+    const T* m_data = nullptr;
+    std::size_t m_size = 0;
+    bool m_borrowed = false;
+};
+
+#endif
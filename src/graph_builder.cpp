@@ -0,0 +1,286 @@
+#include "graph_builder.hpp"
+
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <osmium/io/any_input.hpp>
+#include <osmium/index/id_set.hpp>
+#include <osmium/index/map/all.hpp>
+#include <osmium/osm/relation.hpp>
+#include <osmium/thread/pool.hpp>
+
+#include "chain_contraction.hpp"
+#include "components.hpp"
+#include "geo.hpp"
+#include "osm_pipeline.hpp"
+#include "parallel.hpp"
+#include "road_ways.hpp"
+
+using IdSet = osmium::index::IdSetDense<osmium::unsigned_object_id_type>;
+using LocationIndex = osmium::index::map::Map<osmium::unsigned_object_id_type, osmium::Location>;
+
+// Inputs larger than this get an mmap-backed location index by default
+constexpr std::uintmax_t mmap_index_threshold = 1024ull * 1024 * 1024;
+
+std::string chooseLocationIndex(const std::string& filename, const GraphBuildOptions& options) {
+    if (options.location_index != "auto") return options.location_index;
+    std::error_code ec;
+    std::uintmax_t size = std::filesystem::file_size(filename, ec);
+    if (ec) return "flex_mem";
+
+    if (options.memory_budget_mb > 0) {
+        // PBF needs roughly 8 bytes per node, an in-memory index 16 bytes per
+        // stored node, and only about a fifth of all nodes belong to roads
+        std::uintmax_t estimate = size / 8 * 16;
+        if (options.two_pass) estimate /= 5;
+        if (estimate > static_cast<std::uintmax_t>(options.memory_budget_mb) * 1024 * 1024) {
+            std::filesystem::path dir = options.scratch_dir.empty()
+                ? std::filesystem::temp_directory_path() : std::filesystem::path(options.scratch_dir);
+            return "dense_file_array," + (dir / "route_tracer_locations.tmp").string();
+        }
+    }
+    if (size > mmap_index_threshold) return "dense_mmap_array";
+    return "flex_mem";
+}
+
+// Read-only views of node arrays owned by the caller
+static NodeCoords viewCoords(const NodeCoords& coords) {
+    return NodeCoords(GraphArray<int32_t>::view(coords.lat.data(), coords.size()),
+                      GraphArray<int32_t>::view(coords.lon.data(), coords.size()));
+}
+
+static NodeIdMap viewIds(const NodeIdMap& node_ids) {
+    return NodeIdMap(GraphArray<int64_t>::view(node_ids.osmIds().data(), node_ids.size()),
+                     GraphArray<uint32_t>::view(node_ids.byId().data(), node_ids.byId().size()));
+}
+
+GraphSet buildGraphsFromOsm(const std::string& filename, const GraphBuildOptions& options) {
+    if (options.profiles.empty()) {
+        throw std::invalid_argument("no profile to build");
+    }
+    const std::vector<Profile>& profiles = options.profiles;
+    const std::size_t num_profiles = profiles.size();
+    auto usedByAnyProfile = [&profiles](const WayAttributes& attributes) {
+        for (Profile p : profiles) {
+            if (roadDirection(attributes, p) != WayDirection::none) return true;
+        }
+        return false;
+    };
+
+    const unsigned threads = resolveThreadCount(options.threads);
+    const std::string index_spec = chooseLocationIndex(filename, options);
+    // file-backed indexes are given as "type,path"
+    const std::string index_type = index_spec.substr(0, index_spec.find(','));
+    const std::string index_file = index_spec.size() > index_type.size() ? index_spec.substr(index_type.size() + 1) : "";
+    const auto& map_factory = osmium::index::MapFactory<osmium::unsigned_object_id_type, osmium::Location>::instance();
+    if (!map_factory.has_map_type(index_type)) {
+        throw std::runtime_error("unknown location index type: " + index_type);
+    }
+    std::unique_ptr<LocationIndex> index = map_factory.create_map(index_spec);
+    std::cout << "Location index: " << index_spec << "  Threads: " << threads << "\n";
+    if (!options.region.empty()) {
+        std::cout << "Region: " << options.region.describe() << "\n";
+    }
+
+    // PBF blocks are decompressed on this pool, handler work runs on our own workers
+    osmium::thread::Pool pool(static_cast<int>(threads));
+
+    // first pass (optional): remember the nodes referenced by ways any profile uses
+    IdSet road_nodes;
+    if (options.two_pass) {
+        std::mutex ids_mutex;
+        osmium::io::Reader way_reader(filename, osmium::osm_entity_bits::way, pool, osmium::io::read_meta::no);
+        runBufferPipeline(way_reader, threads,
+            [](const osmium::memory::Buffer&) { return true; },
+            [&](const osmium::memory::Buffer& buffer, std::size_t, unsigned) {
+                std::vector<osmium::unsigned_object_id_type> refs;
+                for (const auto& way : buffer.select<osmium::Way>()) {
+                    if (!usedByAnyProfile(classifyWay(way.tags()))) continue;
+                    for (const auto& node_ref : way.nodes()) {
+                        refs.push_back(node_ref.positive_ref());
+                    }
+                }
+                std::lock_guard<std::mutex> lock(ids_mutex);
+                for (auto id : refs) road_nodes.set(id);
+            });
+        way_reader.close();
+        std::cout << "Road nodes referenced by ways: " << road_nodes.size() << "\n";
+    }
+
+    // second pass: node locations go into the index on this thread, in file order.
+    // Ways follow all nodes in a sorted file, so once the first way shows up the
+    // index is complete and the workers can read it concurrently. Each way is
+    // decoded once and emits edges for every profile. Nodes outside the region
+    // never enter the index, so emitWayEdges skips the segments that touch them.
+    std::vector<std::vector<std::vector<OsmEdge>>> worker_edges(threads, std::vector<std::vector<OsmEdge>>(num_profiles));
+    std::vector<std::vector<std::vector<TurnRestriction>>> worker_restrictions(
+        threads, std::vector<std::vector<TurnRestriction>>(num_profiles));
+    bool ways_started = false;
+    const auto entities = options.turn_restrictions
+        ? osmium::osm_entity_bits::node | osmium::osm_entity_bits::way | osmium::osm_entity_bits::relation
+        : osmium::osm_entity_bits::node | osmium::osm_entity_bits::way;
+    osmium::io::Reader reader(filename, entities, pool, osmium::io::read_meta::no);
+    runBufferPipeline(reader, threads,
+        [&](const osmium::memory::Buffer& buffer) {
+            if (!ways_started) {
+                for (const auto& node : buffer.select<osmium::Node>()) {
+                    if (options.two_pass && !road_nodes.get(node.positive_id())) continue;
+                    if (options.region.contains(node.location())) {
+                        index->set(node.positive_id(), node.location());
+                    }
+                }
+            }
+            auto ways = buffer.select<osmium::Way>();
+            auto relations = buffer.select<osmium::Relation>();
+            if (ways.begin() == ways.end() && relations.begin() == relations.end()) return false;
+            if (!ways_started) {
+                index->sort();
+                ways_started = true;
+            }
+            return true;
+        },
+        [&](const osmium::memory::Buffer& buffer, std::size_t, unsigned worker) {
+            auto location_of = [&index](const osmium::NodeRef& node_ref) {
+                return index->get_noexcept(node_ref.positive_ref());
+            };
+            for (const auto& way : buffer.select<osmium::Way>()) {
+                const WayAttributes attributes = classifyWay(way.tags());
+                for (std::size_t p = 0; p < num_profiles; ++p) {
+                    emitWayEdges(way, attributes, profiles[p], location_of, worker_edges[worker][p]);
+                }
+            }
+            for (const auto& relation : buffer.select<osmium::Relation>()) {
+                for (std::size_t p = 0; p < num_profiles; ++p) {
+                    parseTurnRestrictions(relation, profiles[p], worker_restrictions[worker][p]);
+                }
+            }
+        });
+    reader.close();
+    road_nodes.clear();
+
+    // merge the per-thread edge lists of each profile; normalizeEdges() below
+    // puts them in an order independent of which worker handled which block
+    std::vector<std::vector<OsmEdge>> osm_edges(num_profiles);
+    for (std::size_t p = 0; p < num_profiles; ++p) {
+        std::size_t total = 0;
+        for (const auto& parts : worker_edges) total += parts[p].size();
+        osm_edges[p].reserve(total);
+        for (auto& parts : worker_edges) {
+            osm_edges[p].insert(osm_edges[p].end(), parts[p].begin(), parts[p].end());
+            std::vector<OsmEdge>().swap(parts[p]);
+        }
+    }
+    worker_edges.clear();
+
+    // number the nodes of all profiles 0..n-1 in OSM id order
+    std::vector<int64_t> ids;
+    std::size_t total_edges = 0;
+    for (const auto& part : osm_edges) total_edges += part.size();
+    ids.reserve(total_edges * 2);
+    for (const auto& part : osm_edges) {
+        for (const auto& e : part) {
+            ids.push_back(e.from);
+            ids.push_back(e.to);
+        }
+    }
+    parallelRadixSort(ids, signedKey, threads);
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+
+    // osmium::Location is already 1e-7 degree fixed point: y is lat, x is lon
+    std::vector<int32_t> lat(ids.size()), lon(ids.size());
+    parallelFor(ids.size(), threads, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; ++i) {
+            osmium::Location loc = index->get_noexcept(static_cast<osmium::unsigned_object_id_type>(ids[i]));
+            lat[i] = loc.y();
+            lon[i] = loc.x();
+        }
+    });
+    NodeCoords coords(std::move(lat), std::move(lon));
+    index.reset();
+    if (!index_file.empty() && options.location_index == "auto") {
+        std::error_code ec;
+        std::filesystem::remove(index_file, ec); // scratch file we created ourselves
+    }
+    NodeIdMap node_ids(std::move(ids));
+
+    // until the final numbering is known the graphs borrow coords and node_ids
+    GraphSet set;
+    set.region = options.region.toArray();
+    for (std::size_t p = 0; p < num_profiles; ++p) {
+        // table of the ways that produced edges, so updates can find a way's edges
+        std::vector<int64_t> way_ids;
+        way_ids.reserve(osm_edges[p].size() / 4);
+        for (const auto& e : osm_edges[p]) {
+            way_ids.push_back(e.way);
+        }
+        parallelRadixSort(way_ids, signedKey, threads);
+        way_ids.erase(std::unique(way_ids.begin(), way_ids.end()), way_ids.end());
+
+        std::vector<GraphEdge> edges(osm_edges[p].size());
+        parallelFor(osm_edges[p].size(), threads, [&](std::size_t begin, std::size_t end) {
+            for (std::size_t i = begin; i < end; ++i) {
+                const OsmEdge& e = osm_edges[p][i];
+                uint32_t way = static_cast<uint32_t>(std::lower_bound(way_ids.begin(), way_ids.end(), e.way) - way_ids.begin());
+                edges[i] = {node_ids.indexOf(e.from), node_ids.indexOf(e.to), e.length, e.time, way};
+            }
+        });
+        std::vector<OsmEdge>().swap(osm_edges[p]);
+        const std::size_t dropped = normalizeEdges(edges, threads);
+        if (dropped > 0) {
+            std::cout << profileName(profiles[p]) << ": dropped " << dropped << " self-loops and parallel edges\n";
+        }
+
+        RoadGraph graph = buildRoadGraph(viewCoords(coords), viewIds(node_ids), std::move(way_ids), edges);
+        graph.profile = profiles[p];
+        std::vector<TurnRestriction> restrictions;
+        for (auto& parts : worker_restrictions) {
+            restrictions.insert(restrictions.end(), parts[p].begin(), parts[p].end());
+        }
+        sortTurnRestrictions(restrictions);
+        graph.turn_restrictions = std::move(restrictions);
+        std::vector<GraphEdge>().swap(edges);
+        if (options.contract_chains) {
+            graph = contractChains(std::move(graph));
+        }
+        std::cout << profileName(profiles[p]) << ": " << graph.numEdges() << " edges\n";
+        set.graphs.push_back(std::move(graph));
+    }
+
+    // one numbering for the shared node store: nodes with edges in any profile
+    // first, bfs follows the first profile's edges
+    std::vector<uint32_t> order;
+    if (options.node_order != NodeOrder::osm_id) {
+        std::vector<bool> used(coords.size(), false);
+        for (const RoadGraph& g : set.graphs) {
+            std::vector<bool> has_edges = nodesWithEdges(g);
+            for (std::size_t v = 0; v < used.size(); ++v) {
+                if (has_edges[v]) used[v] = true;
+            }
+        }
+        order = options.node_order == NodeOrder::hilbert ? hilbertOrder(coords, used) : bfsOrder(set.graphs[0], used);
+        for (RoadGraph& g : set.graphs) {
+            g = renumberEdges(std::move(g), order);
+        }
+        coords = permuteCoords(coords, order);
+        node_ids = permuteIds(node_ids, order);
+    }
+    shareNodes(set, std::move(coords), std::move(node_ids));
+
+    for (RoadGraph& g : set.graphs) {
+        if (options.min_component_size > 1) {
+            g = pruneSmallComponents(std::move(g), options.min_component_size);
+        } else {
+            computeComponents(g);
+        }
+        const uint32_t applied = resolveTurnRestrictions(g);
+        if (!g.turn_restrictions.empty()) {
+            std::cout << profileName(g.profile) << ": " << applied << " of " << g.turn_restrictions.size()
+                      << " turn restrictions apply\n";
+        }
+    }
+    return set;
+}
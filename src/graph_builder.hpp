@@ -0,0 +1,62 @@
+#ifndef GRAPH_BUILDER
+#define GRAPH_BUILDER
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "graph_set.hpp"
+#include "node_order.hpp"
+#include "region.hpp"
+#include "road_graph.hpp"
+
+struct GraphBuildOptions {
+    // graphs to build; all of them come out of the same pass over the input
+    std::vector<Profile> profiles = {Profile::car, Profile::bike, Profile::foot};
+
+    // libosmium location index used to resolve way node coordinates:
+    // "flex_mem", "sparse_mem_array", "dense_mmap_array", ... or "auto", which
+    // picks an in-memory or mmap-backed index from the size of the input file
+    std::string location_index = "auto";
+
+    // scan the ways first and only index the nodes that roads reference
+    bool two_pass = true;
+
+    // worker threads for block decoding and edge extraction, 0 = all cores
+    unsigned threads = 0;
+
+    // memory the location index may use, 0 = no limit. If "auto" expects the
+    // in-memory index to exceed it, node locations go to a file-backed index
+    // in scratch_dir (default: the system temp directory) instead.
+    std::size_t memory_budget_mb = 0;
+    std::string scratch_dir;
+
+    // collapse chains of degree-2 nodes into single edges (see contractChains)
+    bool contract_chains = true;
+
+    // read type=restriction relations; searches obey them through
+    // astarWithTurns (see turn_restrictions.hpp)
+    bool turn_restrictions = true;
+
+    // final node numbering, see node_order.hpp
+    NodeOrder node_order = NodeOrder::hilbert;
+
+    // only build from nodes inside this area; ways crossing its boundary are
+    // cut at their last node inside (see region.hpp). Empty keeps everything.
+    Region region;
+
+    // drop strongly connected components with fewer nodes than this, such as
+    // parking aisles or one-way islands; 0 keeps them all
+    uint32_t min_component_size = 0;
+};
+
+// Reads an OSM file and builds one road graph per profile, in the order of
+// options.profiles. The graphs share their node store. Throws on I/O errors or
+// an unknown location index name.
+GraphSet buildGraphsFromOsm(const std::string& filename, const GraphBuildOptions& options);
+
+// Resolves "auto" to a concrete location index type for the given input file.
+std::string chooseLocationIndex(const std::string& filename, const GraphBuildOptions& options);
+
+#endif
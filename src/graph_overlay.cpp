@@ -0,0 +1,418 @@
+#include "graph_overlay.hpp"
+
+#include <algorithm>
+#include <iterator>
+#include <unordered_set>
+
+#include "chain_contraction.hpp"
+#include "components.hpp"
+#include "geo.hpp"
+#include "parallel.hpp"
+#include "spatial_index.hpp"
+
+// per-node flags used while applying a change set
+enum : uint8_t { node_moved = 1, node_deleted = 2 };
+
+Node GraphOverlay::coord(uint32_t v) const {
+    const uint32_t base_n = m_base->numNodes();
+    if (v >= base_n) return m_new_coords[v - base_n];
+    if (!m_moved.empty()) {
+        auto it = m_moved.find(v);
+        if (it != m_moved.end()) return it->second;
+    }
+    return m_base->coords[v];
+}
+
+int64_t GraphOverlay::osmId(uint32_t v) const {
+    const uint32_t base_n = m_base->numNodes();
+    return v < base_n ? m_base->node_ids.osmId(v) : m_new_ids[v - base_n];
+}
+
+uint32_t GraphOverlay::indexOf(int64_t osm_id) const {
+    uint32_t v = m_base->node_ids.indexOf(osm_id);
+    if (v != NodeIdMap::invalid_index) return v;
+    auto it = m_new_index.find(osm_id);
+    return it != m_new_index.end() ? it->second : NodeIdMap::invalid_index;
+}
+
+uint32_t GraphOverlay::addNode(int64_t osm_id, const Node& location) {
+    uint32_t v = numNodes();
+    m_new_coords.push_back(location);
+    m_new_ids.push_back(osm_id);
+    m_new_index.emplace(osm_id, v);
+    return v;
+}
+
+EdgeCost GraphOverlay::edgeCost(uint32_t e) const {
+    if (!m_cost.empty()) {
+        auto it = m_cost.find(e);
+        if (it != m_cost.end()) return it->second;
+    }
+    return {m_base->length[e], m_base->travel_time[e]};
+}
+
+// New cost of an edge whose length changed; the way's speed, and so the
+// ratio of time to length, stays the same
+static EdgeCost remeasure(const EdgeCost& old, double meters) {
+    EdgeCost cost;
+    cost.length = lengthUnits(meters);
+    cost.time = old.length > 0
+        ? static_cast<uint32_t>((uint64_t(old.time) * cost.length + old.length - 1) / old.length)
+        : old.time;
+    return cost;
+}
+
+bool GraphOverlay::hasOutEdges(uint32_t v) const {
+    if (m_added.count(v) > 0) return true;
+    if (v >= m_base->numNodes()) return false;
+    for (uint32_t e = m_base->first_out[v]; e < m_base->first_out[v + 1]; ++e) {
+        if (edgeAlive(e)) return true;
+    }
+    return false;
+}
+
+// In-edges come from the reverse adjacency, or else the component ids, which
+// say whether the node had edges before any were masked; only without either
+// are all base edges scanned.
+bool GraphOverlay::hasEdges(uint32_t v) const {
+    if (hasOutEdges(v)) return true;
+    const RoadGraph& base = *m_base;
+    if (v < base.numNodes()) {
+        if (!base.reverse.empty()) {
+            for (uint32_t i = base.reverse.first_in[v]; i < base.reverse.first_in[v + 1]; ++i) {
+                if (edgeAlive(base.reverse.in_edge[i])) return true;
+            }
+        } else if (!base.component.empty() && (m_deleted_count == 0 || base.component[v] == no_component)) {
+            if (base.component[v] != no_component) return true;
+        } else {
+            for (uint32_t e = 0; e < base.numEdges(); ++e) {
+                if (base.head[e] == v && edgeAlive(e)) return true;
+            }
+        }
+    }
+    for (const auto& entry : m_added) {
+        for (const AddedEdge& e : entry.second) {
+            if (e.to == v) return true;
+        }
+    }
+    return false;
+}
+
+// Added edges carry no geometry; between base nodes the cheapest live base
+// edge is the one the search used unless an update added a shorter one.
+std::vector<uint32_t> GraphOverlay::expandPath(const std::vector<uint32_t>& path, Metric metric) const {
+    const RoadGraph& base = *m_base;
+    if (base.geometry_first.empty()) return path;
+
+    std::vector<uint32_t> full;
+    full.reserve(path.size());
+    for (std::size_t i = 0; i < path.size(); ++i) {
+        full.push_back(path[i]);
+        if (i + 1 == path.size() || path[i] >= base.numNodes()) continue;
+        uint32_t best = NodeIdMap::invalid_index;
+        for (uint32_t e = base.first_out[path[i]]; e < base.first_out[path[i] + 1]; ++e) {
+            if (base.head[e] != path[i + 1] || !edgeAlive(e)) continue;
+            if (best == NodeIdMap::invalid_index || pick(edgeCost(e), metric) < pick(edgeCost(best), metric)) best = e;
+        }
+        if (best == NodeIdMap::invalid_index) continue;
+        for (uint32_t s = base.geometry_first[best]; s < base.geometry_first[best + 1]; ++s) {
+            full.push_back(base.geometry[s]);
+        }
+    }
+    return full;
+}
+
+// the component ids describe the base graph, so with pending changes every
+// query has to be searched
+bool GraphOverlay::mayReach(uint32_t s, uint32_t t) const {
+    return empty() ? ::mayReach(*m_base, s, t) : true;
+}
+
+bool GraphOverlay::changesTurns() const {
+    const RoadGraph& base = *m_base;
+    if (!m_dropped_relations.empty() || !m_added_restrictions.empty()) return true;
+    if (m_added.empty() || base.turn_restrictions.empty()) return false;
+    std::unordered_set<int64_t> restricted_ways;
+    for (const TurnRestriction& r : base.turn_restrictions) {
+        restricted_ways.insert(r.from_way);
+        restricted_ways.insert(r.to_way);
+    }
+    for (const auto& entry : m_added) {
+        if (base.turns.isVia(entry.first)) return true;
+        for (const AddedEdge& e : entry.second) {
+            if (base.turns.isVia(e.to) || restricted_ways.count(e.way) > 0) return true;
+        }
+    }
+    return false;
+}
+
+std::size_t GraphOverlay::pendingChanges() const {
+    return m_deleted_count + m_cost.size() + m_added_count + m_new_coords.size() + m_dropped_relations.size()
+        + m_added_restrictions.size();
+}
+
+bool GraphOverlay::shouldCompact() const {
+    return pendingChanges() > std::max<std::size_t>(1000, m_base->numEdges() / 100);
+}
+
+// The base grid still knows moved nodes at their old place, so those and the
+// added nodes are checked separately. Moved shape nodes are skipped like the
+// grid skips them.
+uint32_t GraphOverlay::nearestNode(double lat, double lon) const {
+    uint32_t best = NodeIdMap::invalid_index;
+    double best_dist = 0;
+    auto consider = [&](uint32_t v) {
+        Node c = coord(v);
+        double d = haversine(lat, lon, c.lat, c.lon);
+        if (best == NodeIdMap::invalid_index || d < best_dist) {
+            best = v;
+            best_dist = d;
+        }
+    };
+
+    if (m_base->numNodes() > 0) consider(findNearestNode(*m_base, lat, lon));
+    for (const auto& entry : m_moved) {
+        if (hasOutEdges(entry.first)) consider(entry.first);
+    }
+    for (uint32_t v = m_base->numNodes(); v < numNodes(); ++v) consider(v);
+    return best;
+}
+
+void GraphOverlay::apply(const GraphChangeSet& changes) {
+    const RoadGraph& base = *m_base;
+    const uint32_t base_n = base.numNodes();
+
+    std::vector<uint8_t> node_flags(numNodes(), 0);
+    bool any_node_changed = false;
+    for (const auto& entry : changes.node_locations) {
+        uint32_t v = indexOf(entry.first);
+        if (v == NodeIdMap::invalid_index) continue; // not a road node (yet)
+        if (v < base_n) {
+            m_moved[v] = entry.second;
+        } else {
+            m_new_coords[v - base_n] = entry.second;
+        }
+        node_flags[v] |= node_moved;
+        any_node_changed = true;
+    }
+    for (int64_t id : changes.deleted_nodes) {
+        uint32_t v = indexOf(id);
+        if (v == NodeIdMap::invalid_index) continue;
+        node_flags[v] |= node_deleted;
+        any_node_changed = true;
+    }
+
+    std::vector<bool> way_touched(base.way_ids.size(), false);
+    bool any_base_way = false;
+    for (int64_t id : changes.touched_ways) {
+        auto it = std::lower_bound(base.way_ids.begin(), base.way_ids.end(), id);
+        if (it != base.way_ids.end() && *it == id) {
+            way_touched[static_cast<std::size_t>(it - base.way_ids.begin())] = true;
+            any_base_way = true;
+        }
+    }
+
+    auto edgeLength = [this](uint32_t u, uint32_t v) {
+        Node a = coord(u);
+        Node b = coord(v);
+        return haversine(a.lat, a.lon, b.lat, b.lon);
+    };
+    // a contracted base edge is measured along its shape nodes
+    const bool has_geometry = !base.geometry_first.empty();
+    auto baseEdgeLength = [&](uint32_t u, uint32_t e) {
+        if (!has_geometry) return edgeLength(u, base.head[e]);
+        double length = 0;
+        uint32_t prev = u;
+        for (uint32_t s = base.geometry_first[e]; s < base.geometry_first[e + 1]; ++s) {
+            length += edgeLength(prev, base.geometry[s]);
+            prev = base.geometry[s];
+        }
+        return length + edgeLength(prev, base.head[e]);
+    };
+
+    // one pass over the base edges: drop edges of touched ways and deleted
+    // nodes, re-measure edges at moved nodes
+    if (any_base_way || any_node_changed) {
+        for (uint32_t u = 0; u < base_n; ++u) {
+            for (uint32_t e = base.first_out[u]; e < base.first_out[u + 1]; ++e) {
+                if (!edgeAlive(e)) continue;
+                const uint32_t v = base.head[e];
+                uint8_t flags = node_flags[u] | node_flags[v];
+                if (has_geometry) {
+                    for (uint32_t s = base.geometry_first[e]; s < base.geometry_first[e + 1]; ++s) {
+                        flags |= node_flags[base.geometry[s]];
+                    }
+                }
+                if (way_touched[base.edge_way[e]] || (flags & node_deleted)) {
+                    if (m_deleted.empty()) m_deleted.assign(base.numEdges(), false);
+                    m_deleted[e] = true;
+                    m_deleted_count++;
+                    m_cost.erase(e);
+                } else if (flags & node_moved) {
+                    m_cost[e] = remeasure({base.length[e], base.travel_time[e]}, baseEdgeLength(u, e));
+                }
+            }
+        }
+    }
+
+    // same for edges added by earlier updates
+    const std::unordered_set<int64_t> touched(changes.touched_ways.begin(), changes.touched_ways.end());
+    auto wayTouched = [&touched](int64_t way) { return touched.count(way) > 0; };
+    for (auto it = m_added.begin(); it != m_added.end();) {
+        const uint32_t u = it->first;
+        auto& out = it->second;
+        const std::size_t before = out.size();
+        out.erase(std::remove_if(out.begin(), out.end(), [&](const AddedEdge& e) {
+            return wayTouched(e.way) || ((node_flags[u] | node_flags[e.to]) & node_deleted);
+        }), out.end());
+        m_added_count -= before - out.size();
+        for (AddedEdge& e : out) {
+            if ((node_flags[u] | node_flags[e.to]) & node_moved) e.cost = remeasure(e.cost, edgeLength(u, e.to));
+        }
+        it = out.empty() ? m_added.erase(it) : std::next(it);
+    }
+
+    // edges of the new way versions; nodes that are new to the graph take their
+    // location from the change set
+    auto resolve = [&](int64_t osm_id) {
+        uint32_t v = indexOf(osm_id);
+        if (v != NodeIdMap::invalid_index) return v;
+        auto loc = changes.node_locations.find(osm_id);
+        if (loc == changes.node_locations.end()) return NodeIdMap::invalid_index;
+        return addNode(osm_id, loc->second);
+    };
+    for (const OsmEdge& e : changes.way_edges) {
+        uint32_t u = resolve(e.from);
+        uint32_t v = resolve(e.to);
+        if (u == NodeIdMap::invalid_index || v == NodeIdMap::invalid_index) continue;
+        m_added[u].push_back({v, {e.length, e.time}, e.way});
+        m_added_count++;
+    }
+
+    // restrictions of touched relations are replaced by their current versions
+    if (!changes.touched_relations.empty()) {
+        const std::unordered_set<int64_t> relations(changes.touched_relations.begin(), changes.touched_relations.end());
+        for (const TurnRestriction& r : base.turn_restrictions) {
+            if (relations.count(r.relation) > 0) m_dropped_relations.insert(r.relation);
+        }
+        m_added_restrictions.erase(std::remove_if(m_added_restrictions.begin(), m_added_restrictions.end(),
+                                                  [&relations](const TurnRestriction& r) {
+                                                      return relations.count(r.relation) > 0;
+                                                  }),
+                                   m_added_restrictions.end());
+    }
+    m_added_restrictions.insert(m_added_restrictions.end(), changes.turn_restrictions.begin(),
+                                changes.turn_restrictions.end());
+}
+
+RoadGraph GraphOverlay::compact() const {
+    const RoadGraph& base = *m_base;
+    const uint32_t n = numNodes();
+    const uint32_t base_n = base.numNodes();
+    const bool has_geometry = !base.geometry_first.empty();
+
+    std::vector<int32_t> lat(n), lon(n);
+    std::vector<int64_t> ids(n);
+    for (uint32_t v = 0; v < n; ++v) {
+        const Node c = coord(v);
+        lat[v] = toFixed(c.lat);
+        lon[v] = toFixed(c.lon);
+        ids[v] = osmId(v);
+    }
+
+    // edges are visited by source node, so the CSR arrays fill in order
+    const std::size_t edge_count = base.numEdges() - m_deleted_count + m_added_count;
+    std::vector<uint32_t> first_out(n + 1, 0);
+    std::vector<uint32_t> head, geometry_first, geometry;
+    std::vector<uint32_t> length, travel_time;
+    std::vector<int64_t> edge_way_ids;
+    head.reserve(edge_count);
+    length.reserve(edge_count);
+    travel_time.reserve(edge_count);
+    edge_way_ids.reserve(edge_count);
+    if (has_geometry) {
+        geometry_first.reserve(edge_count + 1);
+        geometry_first.push_back(0);
+    }
+
+    for (uint32_t u = 0; u < n; ++u) {
+        first_out[u] = static_cast<uint32_t>(head.size());
+        if (u < base_n) {
+            for (uint32_t e = base.first_out[u]; e < base.first_out[u + 1]; ++e) {
+                if (!edgeAlive(e)) continue;
+                head.push_back(base.head[e]);
+                const EdgeCost cost = edgeCost(e);
+                length.push_back(cost.length);
+                travel_time.push_back(cost.time);
+                edge_way_ids.push_back(base.way_ids[base.edge_way[e]]);
+                if (has_geometry) {
+                    geometry.insert(geometry.end(), base.geometry.begin() + base.geometry_first[e],
+                                    base.geometry.begin() + base.geometry_first[e + 1]);
+                    geometry_first.push_back(static_cast<uint32_t>(geometry.size()));
+                }
+            }
+        }
+        if (m_added.empty()) continue;
+        auto it = m_added.find(u);
+        if (it == m_added.end()) continue;
+        for (const AddedEdge& e : it->second) {
+            head.push_back(e.to);
+            length.push_back(e.cost.length);
+            travel_time.push_back(e.cost.time);
+            edge_way_ids.push_back(e.way);
+            if (has_geometry) geometry_first.push_back(static_cast<uint32_t>(geometry.size()));
+        }
+    }
+    first_out[n] = static_cast<uint32_t>(head.size());
+
+    std::vector<int64_t> way_ids(edge_way_ids);
+    std::sort(way_ids.begin(), way_ids.end());
+    way_ids.erase(std::unique(way_ids.begin(), way_ids.end()), way_ids.end());
+    std::vector<uint32_t> edge_way(edge_way_ids.size());
+    for (std::size_t i = 0; i < edge_way_ids.size(); ++i) {
+        edge_way[i] = static_cast<uint32_t>(std::lower_bound(way_ids.begin(), way_ids.end(), edge_way_ids[i]) - way_ids.begin());
+    }
+
+    RoadGraph graph;
+    graph.first_out = std::move(first_out);
+    graph.head = std::move(head);
+    graph.length = std::move(length);
+    graph.travel_time = std::move(travel_time);
+    graph.edge_way = std::move(edge_way);
+    graph.way_ids = std::move(way_ids);
+    graph.coords = NodeCoords(std::move(lat), std::move(lon));
+    graph.node_ids = NodeIdMap(std::move(ids));
+    graph.profile = base.profile;
+    std::vector<TurnRestriction> restrictions;
+    for (const TurnRestriction& r : base.turn_restrictions) {
+        if (m_dropped_relations.count(r.relation) == 0) restrictions.push_back(r);
+    }
+    restrictions.insert(restrictions.end(), m_added_restrictions.begin(), m_added_restrictions.end());
+    sortTurnRestrictions(restrictions);
+    graph.turn_restrictions = std::move(restrictions);
+    if (has_geometry) {
+        // the edges of updated ways arrive uncontracted
+        graph.geometry_first = std::move(geometry_first);
+        graph.geometry = std::move(geometry);
+        graph = contractChains(std::move(graph));
+    }
+    computeComponents(graph);
+    resolveTurnRestrictions(graph);
+    if (!base.grid.empty()) {
+        graph.grid = buildSpatialGrid(graph, base.grid.params.cell_deg);
+    }
+    if (!base.tiles.empty()) {
+        graph.tiles = buildTileIndex(graph, base.tiles.tile_bytes);
+    }
+    if (!base.adjacency.empty()) {
+        graph.adjacency = compressAdjacency(graph);
+    }
+    if (!base.reverse.empty()) {
+        graph.reverse = buildReverseAdjacency(graph);
+    }
+    if (!base.landmarks.empty()) {
+        // costs may have dropped, so the old distances are no longer lower bounds
+        graph.landmarks = buildLandmarks(graph, base.landmarks.count, resolveThreadCount(0));
+    }
+    return graph;
+}
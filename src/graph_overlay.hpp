@@ -0,0 +1,131 @@
+#ifndef GRAPH_OVERLAY
+#define GRAPH_OVERLAY
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "road_graph.hpp"
+
+// Contents of one OsmChange file, reduced to what the road graph needs
+struct GraphChangeSet {
+    std::unordered_map<int64_t, Node> node_locations; // created or modified nodes
+    std::vector<int64_t> deleted_nodes;
+    std::vector<int64_t> touched_ways; // created, modified or deleted; their old edges are dropped
+    std::vector<OsmEdge> way_edges;    // edges of the current versions of the touched ways
+    std::vector<int64_t> touched_relations;         // created, modified or deleted; their old restrictions are dropped
+    std::vector<TurnRestriction> turn_restrictions; // of the current versions of the touched relations
+};
+
+// Changes applied on top of a frozen RoadGraph, searchable through the same
+// interface as the graph itself. The base graph is never modified; deleted
+// edges are masked, changed lengths and locations are looked up in small hash
+// maps, and added edges hang off their source node. compact() folds all of it
+// into a fresh RoadGraph once the overlay grows too large.
+class GraphOverlay {
+public:
+    explicit GraphOverlay(const RoadGraph& base) : m_base(&base) {}
+
+    void apply(const GraphChangeSet& changes);
+
+    // number of masked, re-weighted or added edges, added nodes and replaced
+    // or added turn restrictions
+    std::size_t pendingChanges() const;
+    bool empty() const { return pendingChanges() == 0; }
+    // true once pendingChanges() exceeds about 1% of the base graph
+    bool shouldCompact() const;
+
+    RoadGraph compact() const;
+
+    const RoadGraph& base() const { return *m_base; }
+
+    uint32_t numNodes() const { return m_base->numNodes() + static_cast<uint32_t>(m_new_coords.size()); }
+    Node coord(uint32_t v) const;
+    int64_t osmId(uint32_t v) const;
+    // NodeIdMap::invalid_index if the node is not part of the graph
+    uint32_t indexOf(int64_t osm_id) const;
+    uint32_t nearestNode(double lat, double lon) const;
+    // false for nodes without any edge, such as shape nodes of a contracted
+    // base graph. Scans all edges for nodes without out-edges if the base has
+    // neither a reverse adjacency nor component ids.
+    bool hasEdges(uint32_t v) const;
+
+    // false only if t is known to be unreachable from s
+    bool mayReach(uint32_t s, uint32_t t) const;
+
+    // Path over the overlay expanded with the geometry of the base edges it uses
+    std::vector<uint32_t> expandPath(const std::vector<uint32_t>& path, Metric metric = Metric::distance) const;
+
+    // true if updates changed the turn restrictions, or if an added edge
+    // starts or ends at a via node of the base turn table or belongs to a way
+    // a turn restriction names. The base table cannot tell which turns onto
+    // or off such an edge are forbidden, so turn-aware searches need the
+    // overlay compacted first.
+    bool changesTurns() const;
+
+    template <typename F>
+    void forEachOutEdge(uint32_t v, Metric metric, F&& f) const {
+        forEachOutEdgeIndexed(v, metric, [&f](uint32_t, uint32_t to, uint32_t weight) { f(to, weight); });
+    }
+
+    // f(e, to, weight) like RoadGraph::forEachOutEdgeIndexed; e is the base
+    // edge, or NodeIdMap::invalid_index for an added one. Masked edges are
+    // skipped, so the base turn table still applies to the rest.
+    template <typename F>
+    void forEachOutEdgeIndexed(uint32_t v, Metric metric, F&& f) const {
+        if (v < m_base->numNodes()) {
+            const GraphArray<uint32_t>& weight = m_base->weights(metric);
+            for (uint32_t e = m_base->first_out[v]; e < m_base->first_out[v + 1]; ++e) {
+                if (!m_deleted.empty() && m_deleted[e]) continue;
+                if (!m_cost.empty()) {
+                    auto it = m_cost.find(e);
+                    if (it != m_cost.end()) {
+                        f(e, m_base->head[e], pick(it->second, metric));
+                        continue;
+                    }
+                }
+                f(e, m_base->head[e], weight[e]);
+            }
+        }
+        if (!m_added.empty()) {
+            auto it = m_added.find(v);
+            if (it == m_added.end()) return;
+            for (const AddedEdge& e : it->second) {
+                f(NodeIdMap::invalid_index, e.to, pick(e.cost, metric));
+            }
+        }
+    }
+
+private:
+    struct AddedEdge {
+        uint32_t to;
+        EdgeCost cost;
+        int64_t way;
+    };
+
+    static uint32_t pick(const EdgeCost& cost, Metric metric) {
+        return metric == Metric::time ? cost.time : cost.length;
+    }
+
+    uint32_t addNode(int64_t osm_id, const Node& location);
+    bool edgeAlive(uint32_t e) const { return m_deleted.empty() || !m_deleted[e]; }
+    EdgeCost edgeCost(uint32_t e) const;
+    bool hasOutEdges(uint32_t v) const;
+
+    const RoadGraph* m_base;
+    std::vector<bool> m_deleted;                             // per base edge; empty until the first deletion
+    std::size_t m_deleted_count = 0;
+    std::unordered_map<uint32_t, EdgeCost> m_cost;           // base edges whose length changed
+    std::unordered_map<uint32_t, Node> m_moved;              // base nodes whose location changed
+    std::vector<Node> m_new_coords;                          // nodes added by updates, numbered after the base
+    std::vector<int64_t> m_new_ids;
+    std::unordered_map<int64_t, uint32_t> m_new_index;
+    std::unordered_map<uint32_t, std::vector<AddedEdge>> m_added; // by source node
+    std::size_t m_added_count = 0;
+    std::unordered_set<int64_t> m_dropped_relations;    // base restriction relations updates replaced
+    std::vector<TurnRestriction> m_added_restrictions; // from relations of the updates
+};
+
+#endif
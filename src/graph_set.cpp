@@ -0,0 +1,53 @@
+#include "graph_set.hpp"
+
+#include <memory>
+#include <utility>
+
+const RoadGraph* GraphSet::find(Profile profile) const {
+    for (const RoadGraph& g : graphs) {
+        if (g.profile == profile) return &g;
+    }
+    return nullptr;
+}
+
+RoadGraph* GraphSet::find(Profile profile) {
+    for (RoadGraph& g : graphs) {
+        if (g.profile == profile) return &g;
+    }
+    return nullptr;
+}
+
+bool GraphSet::sharesNodes() const {
+    for (const RoadGraph& g : graphs) {
+        if (g.coords.lat.data() != graphs[0].coords.lat.data()) return false;
+    }
+    return true;
+}
+
+// Owner of node arrays shared by several graphs
+struct NodeStore {
+    NodeCoords coords;
+    NodeIdMap node_ids;
+};
+
+void shareNodes(GraphSet& set, NodeCoords coords, NodeIdMap node_ids) {
+    auto store = std::make_shared<NodeStore>();
+    store->coords = std::move(coords);
+    store->node_ids = std::move(node_ids);
+
+    const NodeCoords& c = store->coords;
+    const NodeIdMap& ids = store->node_ids;
+    for (RoadGraph& g : set.graphs) {
+        g.coords = NodeCoords(GraphArray<int32_t>::view(c.lat.data(), c.size()),
+                              GraphArray<int32_t>::view(c.lon.data(), c.size()));
+        g.node_ids = NodeIdMap(GraphArray<int64_t>::view(ids.osmIds().data(), ids.size()),
+                               GraphArray<uint32_t>::view(ids.byId().data(), ids.byId().size()));
+        // keep whatever the graph's other borrowed arrays live in
+        if (g.storage) {
+            g.storage = std::make_shared<std::pair<std::shared_ptr<const void>, std::shared_ptr<NodeStore>>>(
+                std::move(g.storage), store);
+        } else {
+            g.storage = store;
+        }
+    }
+}
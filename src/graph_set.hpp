@@ -0,0 +1,29 @@
+#ifndef GRAPH_SET
+#define GRAPH_SET
+
+#include <vector>
+
+#include "road_graph.hpp"
+
+// Road graphs of several profiles built from one input. They number nodes the
+// same way and normally share a single node store (coordinates and OSM ids),
+// so only the edge arrays are kept per profile.
+struct GraphSet {
+    std::vector<RoadGraph> graphs;
+    // area the graphs were built from, as Region::toArray() gives it; empty
+    // if they cover the whole input. Updates keep to it.
+    GraphArray<int32_t> region;
+
+    // nullptr if the profile was not built
+    const RoadGraph* find(Profile profile) const;
+    RoadGraph* find(Profile profile);
+
+    // true if every graph reads the node store of the first one
+    bool sharesNodes() const;
+};
+
+// Moves coords and node_ids into one shared store and points the node arrays
+// of every graph at it. All graphs must have coords.size() nodes.
+void shareNodes(GraphSet& set, NodeCoords coords, NodeIdMap node_ids);
+
+#endif
@@ -0,0 +1,468 @@
+#include "graph_snapshot.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+#include <cstdio>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+constexpr char snapshot_magic[8] = {'R', 'T', 'G', 'R', 'A', 'P', 'H', '\0'};
+constexpr uint32_t byte_order_mark = 0x01020304;
+constexpr uint64_t page_size = 4096;
+constexpr uint32_t max_sections = 128;
+
+// Sections of the graph in slot p of the profile table are tagged with p + 1
+// in the upper bits. Node sections without a tag belong to all graphs.
+constexpr uint32_t profile_section_shift = 8;
+
+static uint32_t profileSection(std::size_t slot, uint32_t id) {
+    return static_cast<uint32_t>(slot + 1) << profile_section_shift | id;
+}
+
+struct SnapshotHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint64_t file_size;
+    uint32_t section_count;
+    uint32_t reserved;
+    SectionEntry sections[max_sections];
+};
+static_assert(sizeof(SnapshotHeader) <= page_size, "snapshot header must fit in one page");
+
+// One array to be written
+struct SectionSource {
+    uint32_t id;
+    uint32_t element_size;
+    const void* data;
+    uint64_t count;
+};
+
+template <typename T>
+static SectionSource makeSection(uint32_t id, const GraphArray<T>& array) {
+    return {id, static_cast<uint32_t>(sizeof(T)), array.data(), array.size()};
+}
+
+template <typename T>
+static SectionSource makeSection(uint32_t id, const T& value) {
+    return {id, static_cast<uint32_t>(sizeof(T)), &value, 1};
+}
+
+static uint64_t alignToPage(uint64_t offset) {
+    return (offset + page_size - 1) / page_size * page_size;
+}
+
+void writeSnapshot(const GraphSet& set, const std::string& filename) {
+    if (set.graphs.empty()) {
+        throw std::runtime_error("no graph to write to " + filename);
+    }
+    std::vector<uint8_t> profile_values;
+    for (const RoadGraph& graph : set.graphs) {
+        profile_values.push_back(static_cast<uint8_t>(graph.profile));
+    }
+    const GraphArray<uint8_t> profiles = GraphArray<uint8_t>::view(profile_values.data(), profile_values.size());
+    std::vector<SectionSource> sources = {makeSection(section_profiles, profiles)};
+    if (!set.region.empty()) {
+        sources.push_back(makeSection(section_region, set.region));
+    }
+
+    auto addNodeSections = [&sources](const RoadGraph& graph, auto&& id) {
+        sources.push_back(makeSection(id(section_lat), graph.coords.lat));
+        sources.push_back(makeSection(id(section_lon), graph.coords.lon));
+        sources.push_back(makeSection(id(section_osm_ids), graph.node_ids.osmIds()));
+        sources.push_back(makeSection(id(section_osm_id_order), graph.node_ids.byId()));
+    };
+    const bool shared_nodes = set.sharesNodes();
+    if (shared_nodes) {
+        addNodeSections(set.graphs[0], [](uint32_t id) { return id; });
+    }
+    for (std::size_t slot = 0; slot < set.graphs.size(); ++slot) {
+        const RoadGraph& graph = set.graphs[slot];
+        auto id = [slot](uint32_t section) { return profileSection(slot, section); };
+        if (!shared_nodes) {
+            addNodeSections(graph, id);
+        }
+        sources.push_back(makeSection(id(section_first_out), graph.first_out));
+        sources.push_back(makeSection(id(section_head), graph.head));
+        sources.push_back(makeSection(id(section_length), graph.length));
+        sources.push_back(makeSection(id(section_travel_time), graph.travel_time));
+        sources.push_back(makeSection(id(section_edge_way), graph.edge_way));
+        sources.push_back(makeSection(id(section_way_ids), graph.way_ids));
+        if (!graph.geometry_first.empty()) {
+            sources.push_back(makeSection(id(section_geometry_first), graph.geometry_first));
+            sources.push_back(makeSection(id(section_geometry), graph.geometry));
+        }
+        if (!graph.component.empty()) {
+            sources.push_back(makeSection(id(section_component), graph.component));
+            sources.push_back(makeSection(id(section_component_flags), graph.component_flags));
+        }
+        if (!graph.turn_restrictions.empty()) {
+            sources.push_back(makeSection(id(section_turn_restrictions), graph.turn_restrictions));
+        }
+        if (!graph.turns.empty()) {
+            sources.push_back(makeSection(id(section_turn_via_bits), graph.turns.via_bits));
+            sources.push_back(makeSection(id(section_turn_via_nodes), graph.turns.via_nodes));
+            sources.push_back(makeSection(id(section_turn_in_first), graph.turns.in_first));
+            sources.push_back(makeSection(id(section_turn_in_edges), graph.turns.in_edges));
+            sources.push_back(makeSection(id(section_turn_forbidden_first), graph.turns.forbidden_first));
+            sources.push_back(makeSection(id(section_turn_forbidden), graph.turns.forbidden));
+        }
+        if (!graph.grid.empty()) {
+            sources.push_back(makeSection(id(section_grid_params), graph.grid.params));
+            sources.push_back(makeSection(id(section_grid_first), graph.grid.first));
+            sources.push_back(makeSection(id(section_grid_nodes), graph.grid.nodes));
+        }
+        if (!graph.tiles.empty()) {
+            sources.push_back(makeSection(id(section_tile_params), graph.tiles.tile_bytes));
+            sources.push_back(makeSection(id(section_tile_first_node), graph.tiles.first_node));
+            sources.push_back(makeSection(id(section_tile_boundary_first), graph.tiles.boundary_first));
+            sources.push_back(makeSection(id(section_tile_boundary_edges), graph.tiles.boundary_edges));
+        }
+        if (!graph.adjacency.empty()) {
+            sources.push_back(makeSection(id(section_adjacency_first), graph.adjacency.first_byte));
+            sources.push_back(makeSection(id(section_adjacency_bytes), graph.adjacency.bytes));
+        }
+        if (!graph.reverse.empty()) {
+            sources.push_back(makeSection(id(section_reverse_first_in), graph.reverse.first_in));
+            sources.push_back(makeSection(id(section_reverse_tail), graph.reverse.tail));
+            sources.push_back(makeSection(id(section_reverse_in_edge), graph.reverse.in_edge));
+        }
+        if (!graph.landmarks.empty()) {
+            const LandmarkTables& landmarks = graph.landmarks;
+            sources.push_back(makeSection(id(section_landmark_params), landmarks.count));
+            sources.push_back(makeSection(id(section_landmark_nodes), landmarks.nodes));
+            sources.push_back(makeSection(id(section_landmark_from_distance), landmarks.from_distance));
+            sources.push_back(makeSection(id(section_landmark_to_distance), landmarks.to_distance));
+            sources.push_back(makeSection(id(section_landmark_from_time), landmarks.from_time));
+            sources.push_back(makeSection(id(section_landmark_to_time), landmarks.to_time));
+        }
+    }
+    if (sources.size() > max_sections) {
+        throw std::runtime_error("too many graph arrays for one snapshot: " + filename);
+    }
+
+    SnapshotHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, snapshot_magic, sizeof(snapshot_magic));
+    header.version = snapshot_version;
+    header.byte_order = byte_order_mark;
+    header.section_count = static_cast<uint32_t>(sources.size());
+
+    uint64_t offset = page_size;
+    for (std::size_t i = 0; i < sources.size(); ++i) {
+        header.sections[i] = {sources[i].id, sources[i].element_size, offset, sources[i].count};
+        offset = alignToPage(offset + sources[i].count * sources[i].element_size);
+    }
+    header.file_size = offset;
+
+    const std::string tmp_name = filename + ".tmp";
+    std::ofstream out(tmp_name, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        throw std::runtime_error("cannot create snapshot file " + tmp_name);
+    }
+
+    const std::vector<char> padding(page_size, 0);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(padding.data(), page_size - sizeof(header));
+    for (std::size_t i = 0; i < sources.size(); ++i) {
+        const uint64_t bytes = sources[i].count * sources[i].element_size;
+        if (bytes > 0) {
+            out.write(static_cast<const char*>(sources[i].data), static_cast<std::streamsize>(bytes));
+        }
+        const uint64_t end = header.sections[i].offset + bytes;
+        out.write(padding.data(), static_cast<std::streamsize>(alignToPage(end) - end));
+    }
+    out.close();
+    if (!out) {
+        std::remove(tmp_name.c_str());
+        throw std::runtime_error("failed writing snapshot file " + tmp_name);
+    }
+
+    if (std::rename(tmp_name.c_str(), filename.c_str()) != 0) {
+        std::remove(tmp_name.c_str());
+        throw std::runtime_error("cannot move snapshot into place at " + filename);
+    }
+}
+
+// Read-only mapping of a whole file, unmapped when the last graph using it goes away
+struct MappedFile {
+    void* data = MAP_FAILED;
+    std::size_t size = 0;
+
+    ~MappedFile() {
+        if (data != MAP_FAILED) munmap(data, size);
+    }
+};
+
+static std::shared_ptr<MappedFile> mapFile(const std::string& filename) {
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("cannot open snapshot file " + filename);
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(page_size)) {
+        close(fd);
+        throw std::runtime_error("snapshot file is truncated: " + filename);
+    }
+
+    auto mapped = std::make_shared<MappedFile>();
+    mapped->size = static_cast<std::size_t>(st.st_size);
+    mapped->data = mmap(nullptr, mapped->size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd); // the mapping stays valid without the descriptor
+    if (mapped->data == MAP_FAILED) {
+        throw std::runtime_error("cannot map snapshot file " + filename);
+    }
+    return mapped;
+}
+
+template <typename T>
+static GraphArray<T> sectionView(const SnapshotHeader& header, const MappedFile& file,
+                                 uint32_t id, bool required) {
+    for (uint32_t i = 0; i < header.section_count; ++i) {
+        const SectionEntry& entry = header.sections[i];
+        if (entry.id != id) continue;
+        if (entry.element_size != sizeof(T) || entry.offset % page_size != 0 ||
+            entry.offset > file.size || entry.count > (file.size - entry.offset) / sizeof(T)) {
+            throw std::runtime_error("corrupt snapshot section " + std::to_string(id));
+        }
+        const char* base = static_cast<const char*>(file.data) + entry.offset;
+        return GraphArray<T>::view(reinterpret_cast<const T*>(base), entry.count);
+    }
+    if (required) {
+        throw std::runtime_error("snapshot is missing section " + std::to_string(id));
+    }
+    return {};
+}
+
+template <typename T>
+static GraphArray<T> sectionView(const SnapshotHeader& header, const MappedFile& file,
+                                 std::size_t slot, uint32_t id, bool required) {
+    return sectionView<T>(header, file, profileSection(slot, id), required);
+}
+
+// Node sections of a graph, falling back to the untagged shared ones
+template <typename T>
+static GraphArray<T> nodeSectionView(const SnapshotHeader& header, const MappedFile& file,
+                                     std::size_t slot, uint32_t id, bool required) {
+    GraphArray<T> own = sectionView<T>(header, file, slot, id, false);
+    if (!own.empty()) return own;
+    return sectionView<T>(header, file, id, required);
+}
+
+static RoadGraph loadGraph(const SnapshotHeader& header, const std::shared_ptr<MappedFile>& file,
+                           std::size_t slot, Profile profile, const std::string& filename) {
+    RoadGraph graph;
+    graph.profile = profile;
+    graph.first_out = sectionView<uint32_t>(header, *file, slot, section_first_out, true);
+    graph.head = sectionView<uint32_t>(header, *file, slot, section_head, true);
+    graph.length = sectionView<uint32_t>(header, *file, slot, section_length, true);
+    graph.travel_time = sectionView<uint32_t>(header, *file, slot, section_travel_time, true);
+    graph.edge_way = sectionView<uint32_t>(header, *file, slot, section_edge_way, true);
+    graph.way_ids = sectionView<int64_t>(header, *file, slot, section_way_ids, true);
+    graph.geometry_first = sectionView<uint32_t>(header, *file, slot, section_geometry_first, false);
+    if (!graph.geometry_first.empty()) {
+        graph.geometry = sectionView<uint32_t>(header, *file, slot, section_geometry, true);
+    }
+    graph.component = sectionView<uint32_t>(header, *file, slot, section_component, false);
+    if (!graph.component.empty()) {
+        graph.component_flags = sectionView<uint8_t>(header, *file, slot, section_component_flags, true);
+    }
+    graph.coords = NodeCoords(nodeSectionView<int32_t>(header, *file, slot, section_lat, true),
+                              nodeSectionView<int32_t>(header, *file, slot, section_lon, true));
+    graph.node_ids = NodeIdMap(nodeSectionView<int64_t>(header, *file, slot, section_osm_ids, true),
+                               nodeSectionView<uint32_t>(header, *file, slot, section_osm_id_order, false));
+
+    graph.turn_restrictions = sectionView<TurnRestriction>(header, *file, slot, section_turn_restrictions, false);
+    TurnTable& turns = graph.turns;
+    turns.via_nodes = sectionView<uint32_t>(header, *file, slot, section_turn_via_nodes, false);
+    if (!turns.via_nodes.empty()) {
+        turns.via_bits = sectionView<uint64_t>(header, *file, slot, section_turn_via_bits, true);
+        turns.in_first = sectionView<uint32_t>(header, *file, slot, section_turn_in_first, true);
+        turns.in_edges = sectionView<uint32_t>(header, *file, slot, section_turn_in_edges, true);
+        turns.forbidden_first = sectionView<uint32_t>(header, *file, slot, section_turn_forbidden_first, true);
+        turns.forbidden = sectionView<uint64_t>(header, *file, slot, section_turn_forbidden, true);
+    }
+
+    GraphArray<GridParams> grid_params = sectionView<GridParams>(header, *file, slot, section_grid_params, false);
+    if (grid_params.size() == 1) {
+        graph.grid.params = grid_params[0];
+        graph.grid.first = sectionView<uint32_t>(header, *file, slot, section_grid_first, true);
+        graph.grid.nodes = sectionView<uint32_t>(header, *file, slot, section_grid_nodes, true);
+    }
+    GraphArray<uint64_t> tile_params = sectionView<uint64_t>(header, *file, slot, section_tile_params, false);
+    TileIndex& tiles = graph.tiles;
+    if (tile_params.size() == 1) {
+        tiles.tile_bytes = tile_params[0];
+        tiles.first_node = sectionView<uint32_t>(header, *file, slot, section_tile_first_node, true);
+        tiles.boundary_first = sectionView<uint32_t>(header, *file, slot, section_tile_boundary_first, true);
+        tiles.boundary_edges = sectionView<uint32_t>(header, *file, slot, section_tile_boundary_edges, true);
+    }
+    CompressedAdjacency& adjacency = graph.adjacency;
+    adjacency.first_byte = sectionView<uint32_t>(header, *file, slot, section_adjacency_first, false);
+    if (!adjacency.empty()) {
+        adjacency.bytes = sectionView<uint8_t>(header, *file, slot, section_adjacency_bytes, true);
+    }
+    ReverseAdjacency& reverse = graph.reverse;
+    reverse.first_in = sectionView<uint32_t>(header, *file, slot, section_reverse_first_in, false);
+    if (!reverse.empty()) {
+        reverse.tail = sectionView<uint32_t>(header, *file, slot, section_reverse_tail, true);
+        reverse.in_edge = sectionView<uint32_t>(header, *file, slot, section_reverse_in_edge, true);
+    }
+    GraphArray<uint32_t> landmark_params = sectionView<uint32_t>(header, *file, slot, section_landmark_params, false);
+    LandmarkTables& landmarks = graph.landmarks;
+    if (landmark_params.size() == 1) {
+        landmarks.count = landmark_params[0];
+        landmarks.stride = (landmarks.count + landmark_lanes - 1) / landmark_lanes * landmark_lanes;
+        landmarks.nodes = sectionView<uint32_t>(header, *file, slot, section_landmark_nodes, true);
+        landmarks.from_distance = sectionView<uint32_t>(header, *file, slot, section_landmark_from_distance, true);
+        landmarks.to_distance = sectionView<uint32_t>(header, *file, slot, section_landmark_to_distance, true);
+        landmarks.from_time = sectionView<uint32_t>(header, *file, slot, section_landmark_from_time, true);
+        landmarks.to_time = sectionView<uint32_t>(header, *file, slot, section_landmark_to_time, true);
+    }
+
+    const std::size_t n = graph.coords.size();
+    if (graph.first_out.size() != n + 1 || graph.first_out[n] != graph.head.size() ||
+        graph.length.size() != graph.head.size() || graph.travel_time.size() != graph.head.size() || graph.edge_way.size() != graph.head.size() ||
+        graph.coords.lon.size() != n || graph.node_ids.size() != n ||
+        (!graph.component.empty() && graph.component.size() != n) ||
+        (!graph.geometry_first.empty() && (graph.geometry_first.size() != graph.head.size() + 1 ||
+                                           graph.geometry_first[graph.head.size()] != graph.geometry.size())) ||
+        (!graph.node_ids.byId().empty() && graph.node_ids.byId().size() != n) ||
+        (!graph.grid.empty() && (graph.grid.first.size() != std::size_t(graph.grid.params.rows) * graph.grid.params.cols + 1 ||
+                                 graph.grid.nodes.size() > n)) ||
+        (!tiles.empty() && (tiles.first_node.size() < 2 || tiles.first_node[tiles.numTiles()] != n ||
+                            tiles.boundary_first.size() != tiles.first_node.size() ||
+                            tiles.boundary_first[tiles.numTiles()] != tiles.boundary_edges.size())) ||
+        (!adjacency.empty() && (adjacency.first_byte.size() != n + 1 ||
+                                adjacency.first_byte[n] != adjacency.bytes.size())) ||
+        (!reverse.empty() && (reverse.first_in.size() != n + 1 || reverse.first_in[n] != graph.head.size() ||
+                              reverse.tail.size() != graph.head.size() || reverse.in_edge.size() != graph.head.size())) ||
+        (!landmarks.empty() && (landmarks.count > max_landmarks || landmarks.nodes.size() != landmarks.count ||
+                                landmarks.from_distance.size() != n * landmarks.stride ||
+                                landmarks.to_distance.size() != n * landmarks.stride ||
+                                landmarks.from_time.size() != n * landmarks.stride ||
+                                landmarks.to_time.size() != n * landmarks.stride)) ||
+        (!turns.empty() && (turns.via_bits.size() != (n + 63) / 64 || turns.in_first.size() != turns.via_nodes.size() + 1 ||
+                            turns.in_first[turns.via_nodes.size()] != turns.in_edges.size() ||
+                            turns.forbidden_first.size() != turns.via_nodes.size() + 1 ||
+                            turns.forbidden.size() != (turns.forbidden_first[turns.via_nodes.size()] + 63) / 64))) {
+        throw std::runtime_error("snapshot sections do not match: " + filename);
+    }
+
+    graph.storage = file;
+    return graph;
+}
+
+static void checkHeader(const SnapshotHeader& header, uint64_t file_size, const std::string& filename) {
+    if (std::memcmp(header.magic, snapshot_magic, sizeof(snapshot_magic)) != 0) {
+        throw std::runtime_error("not a route_tracer snapshot: " + filename);
+    }
+    if (header.version != snapshot_version || header.byte_order != byte_order_mark) {
+        throw std::runtime_error("snapshot was written by an incompatible build: " + filename);
+    }
+    if (header.file_size != file_size || header.section_count > max_sections) {
+        throw std::runtime_error("snapshot file is truncated: " + filename);
+    }
+}
+
+static Profile profileAt(const GraphArray<uint8_t>& profiles, std::size_t slot, const std::string& filename) {
+    if (profiles[slot] > static_cast<uint8_t>(Profile::foot)) {
+        throw std::runtime_error("snapshot has an unknown profile: " + filename);
+    }
+    return static_cast<Profile>(profiles[slot]);
+}
+
+GraphSet loadSnapshot(const std::string& filename) {
+    std::shared_ptr<MappedFile> file = mapFile(filename);
+    const auto& header = *static_cast<const SnapshotHeader*>(file->data);
+    checkHeader(header, file->size, filename);
+
+    GraphArray<uint8_t> profiles = sectionView<uint8_t>(header, *file, section_profiles, true);
+    GraphSet set;
+    for (std::size_t slot = 0; slot < profiles.size(); ++slot) {
+        set.graphs.push_back(loadGraph(header, file, slot, profileAt(profiles, slot, filename), filename));
+    }
+    if (set.graphs.empty()) {
+        throw std::runtime_error("snapshot holds no graph: " + filename);
+    }
+    // small, so copied rather than tied to the mapping
+    const GraphArray<int32_t> region = sectionView<int32_t>(header, *file, section_region, false);
+    if (!region.empty() && (region.size() < 6 || (region.size() - 6) % 4 != 0)) {
+        throw std::runtime_error("corrupt snapshot section " + std::to_string(section_region));
+    }
+    set.region = std::vector<int32_t>(region.begin(), region.end());
+    return set;
+}
+
+const SectionEntry* SnapshotLayout::find(std::size_t slot, uint32_t id) const {
+    const uint32_t tagged = profileSection(slot, id);
+    const SectionEntry* shared = nullptr;
+    for (const SectionEntry& entry : sections) {
+        if (entry.id == tagged) return &entry;
+        if (entry.id == id) shared = &entry;
+    }
+    return shared;
+}
+
+// Reads count bytes at offset, throwing on short reads
+static void readAt(int fd, void* data, std::size_t count, uint64_t offset, const std::string& filename) {
+    char* out = static_cast<char*>(data);
+    while (count > 0) {
+        const ssize_t got = pread(fd, out, count, static_cast<off_t>(offset));
+        if (got <= 0) {
+            throw std::runtime_error("cannot read snapshot file " + filename);
+        }
+        out += got;
+        count -= static_cast<std::size_t>(got);
+        offset += static_cast<uint64_t>(got);
+    }
+}
+
+SnapshotLayout readSnapshotLayout(const std::string& filename) {
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("cannot open snapshot file " + filename);
+    }
+    SnapshotLayout layout;
+    try {
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(page_size)) {
+            throw std::runtime_error("snapshot file is truncated: " + filename);
+        }
+        SnapshotHeader header;
+        readAt(fd, &header, sizeof(header), 0, filename);
+        checkHeader(header, static_cast<uint64_t>(st.st_size), filename);
+
+        for (uint32_t i = 0; i < header.section_count; ++i) {
+            const SectionEntry& entry = header.sections[i];
+            if (entry.element_size == 0 || entry.offset % page_size != 0 || entry.offset > header.file_size ||
+                entry.count > (header.file_size - entry.offset) / entry.element_size) {
+                throw std::runtime_error("corrupt snapshot section " + std::to_string(entry.id));
+            }
+            layout.sections.push_back(entry);
+        }
+
+        const SectionEntry* profiles = layout.find(0, section_profiles);
+        if (!profiles || profiles->element_size != 1) {
+            throw std::runtime_error("snapshot is missing section " + std::to_string(section_profiles));
+        }
+        std::vector<uint8_t> values(profiles->count);
+        readAt(fd, values.data(), values.size(), profiles->offset, filename);
+        const GraphArray<uint8_t> view = GraphArray<uint8_t>::view(values.data(), values.size());
+        for (std::size_t slot = 0; slot < view.size(); ++slot) {
+            layout.profiles.push_back(profileAt(view, slot, filename));
+        }
+    } catch (...) {
+        close(fd);
+        throw;
+    }
+    close(fd);
+    if (layout.profiles.empty()) {
+        throw std::runtime_error("snapshot holds no graph: " + filename);
+    }
+    return layout;
+}
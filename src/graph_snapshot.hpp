@@ -0,0 +1,94 @@
+#ifndef GRAPH_SNAPSHOT
+#define GRAPH_SNAPSHOT
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "graph_set.hpp"
+
+// On-disk image of a built GraphSet: a header page with a section table,
+// followed by the graph arrays, each starting on a page boundary and stored in
+// the machine's native layout. Loading maps the file read-only and the graph
+// arrays point straight into the mapping, so there is nothing to deserialize.
+// A node store shared by all profiles is stored once.
+constexpr uint32_t snapshot_version = 14;
+
+// Writes to a temporary file next to filename and renames it into place, so
+// processes that still map an older snapshot keep a consistent view.
+// Throws std::runtime_error on I/O errors.
+void writeSnapshot(const GraphSet& set, const std::string& filename);
+
+// Throws std::runtime_error if the file is missing, truncated or was written
+// by an incompatible version.
+GraphSet loadSnapshot(const std::string& filename);
+
+// Ids of the arrays in the section table
+enum SectionId : uint32_t {
+    section_first_out = 1,
+    section_head = 2,
+    section_osm_ids = 5,
+    section_osm_id_order = 6,
+    section_grid_params = 7,
+    section_grid_first = 8,
+    section_grid_nodes = 9,
+    section_edge_way = 10,
+    section_way_ids = 11,
+    section_geometry_first = 12,
+    section_geometry = 13,
+    section_component = 14,
+    section_component_flags = 15,
+    section_lat = 16,
+    section_lon = 17,
+    section_length = 18,
+    section_travel_time = 19,
+    section_profiles = 20,
+    section_turn_restrictions = 21,
+    section_turn_via_bits = 22,
+    section_turn_via_nodes = 23,
+    section_turn_in_first = 24,
+    section_turn_in_edges = 25,
+    section_turn_forbidden_first = 26,
+    section_turn_forbidden = 27,
+    section_tile_params = 28,
+    section_tile_first_node = 29,
+    section_tile_boundary_first = 30,
+    section_tile_boundary_edges = 31,
+    section_adjacency_first = 32,
+    section_adjacency_bytes = 33,
+    section_reverse_first_in = 34,
+    section_reverse_tail = 35,
+    section_reverse_in_edge = 36,
+    section_landmark_params = 37,
+    section_landmark_nodes = 38,
+    section_landmark_from_distance = 39,
+    section_landmark_to_distance = 40,
+    section_landmark_from_time = 41,
+    section_landmark_to_time = 42,
+    section_region = 43,
+};
+
+// Entry of the section table in the header page
+struct SectionEntry {
+    uint32_t id;
+    uint32_t element_size;
+    uint64_t offset; // from the start of the file, page aligned
+    uint64_t count;  // number of elements
+};
+
+// Where the arrays of a snapshot lie in the file, for readers that fetch
+// parts of a graph on demand (TiledGraph) instead of mapping all of it
+struct SnapshotLayout {
+    std::vector<Profile> profiles; // graph slots in file order
+    std::vector<SectionEntry> sections;
+
+    // Array id of the graph in slot, falling back to the node store shared by
+    // all graphs; nullptr if the snapshot does not have it
+    const SectionEntry* find(std::size_t slot, uint32_t id) const;
+};
+
+// Reads and checks the header page and the profile table. Throws like
+// loadSnapshot.
+SnapshotLayout readSnapshotLayout(const std::string& filename);
+
+#endif
@@ -0,0 +1,45 @@
+#include "graph_tiles.hpp"
+
+#include <utility>
+#include <vector>
+
+#include "road_graph.hpp"
+
+TileIndex buildTileIndex(const RoadGraph& g, uint64_t tile_bytes) {
+    TileIndex tiles;
+    const uint32_t n = g.numNodes();
+    if (n == 0) return tiles;
+
+    // boundary edges are not known before the cut, so every edge is
+    // counted at the larger boundary size
+    std::vector<uint32_t> first_node = {0};
+    uint64_t bytes = 0;
+    for (uint32_t v = 0; v < n; ++v) {
+        const uint64_t node_bytes = tile_bytes_per_node + uint64_t(g.first_out[v + 1] - g.first_out[v]) * tile_bytes_per_edge;
+        const uint32_t tile_nodes = v - first_node.back();
+        if (tile_nodes > 0 && (bytes + node_bytes > tile_bytes || tile_nodes == max_tile_nodes)) {
+            first_node.push_back(v);
+            bytes = 0;
+        }
+        bytes += node_bytes;
+    }
+    first_node.push_back(n);
+
+    const uint32_t count = static_cast<uint32_t>(first_node.size() - 1);
+    std::vector<uint32_t> boundary_first = {0};
+    std::vector<uint32_t> boundary_edges;
+    for (uint32_t t = 0; t < count; ++t) {
+        const uint32_t begin = first_node[t];
+        const uint32_t end = first_node[t + 1];
+        for (uint32_t e = g.first_out[begin]; e < g.first_out[end]; ++e) {
+            if (g.head[e] < begin || g.head[e] >= end) boundary_edges.push_back(e);
+        }
+        boundary_first.push_back(static_cast<uint32_t>(boundary_edges.size()));
+    }
+
+    tiles.tile_bytes = tile_bytes;
+    tiles.first_node = std::move(first_node);
+    tiles.boundary_first = std::move(boundary_first);
+    tiles.boundary_edges = std::move(boundary_edges);
+    return tiles;
+}
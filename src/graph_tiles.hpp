@@ -0,0 +1,46 @@
+#ifndef GRAPH_TILES
+#define GRAPH_TILES
+
+#include <algorithm>
+#include <cstdint>
+
+#include "graph_array.hpp"
+
+struct RoadGraph;
+
+// A tile never spans more nodes than this, so edges inside it can name their
+// target with 16 bits (see TiledGraph)
+constexpr uint32_t max_tile_nodes = 65536;
+
+// Partition of a graph into tiles of consecutive nodes for TiledGraph. With
+// the nodes in Hilbert order each tile covers a compact patch of the map. The
+// edges of tile t that lead into another tile are listed in
+// boundary_edges[boundary_first[t] .. boundary_first[t + 1] - 1], ascending;
+// all other edges of the tile stay inside it.
+struct TileIndex {
+    uint64_t tile_bytes = 0;           // size the tiles were cut to
+    GraphArray<uint32_t> first_node;   // numTiles() + 1 entries, the last is numNodes()
+    GraphArray<uint32_t> boundary_first; // numTiles() + 1 entries
+    GraphArray<uint32_t> boundary_edges;
+
+    bool empty() const { return first_node.empty(); }
+    uint32_t numTiles() const { return empty() ? 0 : static_cast<uint32_t>(first_node.size() - 1); }
+
+    uint32_t tileOf(uint32_t v) const {
+        return static_cast<uint32_t>(std::upper_bound(first_node.begin(), first_node.end(), v) - first_node.begin()) - 1;
+    }
+};
+
+// Tile size prep and the router cut to unless told otherwise
+constexpr uint64_t default_tile_bytes = 512 * 1024;
+
+// Bytes a tile takes in memory per node and per edge, as TiledGraph lays it out
+constexpr uint64_t tile_bytes_per_node = 28;
+constexpr uint64_t tile_bytes_per_edge = 12;
+
+// Cuts the nodes of g into tiles of about tile_bytes each. Nodes are not
+// reordered, so call this after renumberNodes(); a tile holds at least one
+// node and at most max_tile_nodes.
+TileIndex buildTileIndex(const RoadGraph& g, uint64_t tile_bytes);
+
+#endif
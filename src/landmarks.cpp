@@ -0,0 +1,152 @@
+#include "landmarks.hpp"
+
+#include <utility>
+
+#include "parallel.hpp"
+#include "road_graph.hpp"
+#include "search_queues.hpp"
+
+const GraphArray<uint32_t>& LandmarkTables::from(Metric metric) const {
+    return metric == Metric::time ? from_time : from_distance;
+}
+
+const GraphArray<uint32_t>& LandmarkTables::to(Metric metric) const {
+    return metric == Metric::time ? to_time : to_distance;
+}
+
+// Plain Dijkstra from source, over out-edges or, backwards, over the in-edges
+// of reverse
+static std::vector<uint32_t> shortestCosts(const RoadGraph& g, const ReverseAdjacency& reverse, uint32_t source,
+                                           Metric metric, bool backward) {
+    const GraphArray<uint32_t>& weight = g.weights(metric);
+    std::vector<uint32_t> cost(g.numNodes(), landmark_unreachable);
+    IndexedDaryHeap<4> queue;
+    queue.reset(g.numNodes());
+    cost[source] = 0;
+    queue.push(source, 0);
+    while (!queue.empty()) {
+        const auto [u, cu] = queue.pop();
+        auto relax = [&](uint32_t v, uint32_t w) {
+            if (cu + w < cost[v]) {
+                cost[v] = cu + w;
+                queue.push(v, cost[v]);
+            }
+        };
+        if (backward) {
+            for (uint32_t i = reverse.first_in[u]; i < reverse.first_in[u + 1]; ++i) {
+                relax(reverse.tail[i], weight[reverse.in_edge[i]]);
+            }
+        } else {
+            for (uint32_t e = g.first_out[u]; e < g.first_out[u + 1]; ++e) {
+                relax(g.head[e], weight[e]);
+            }
+        }
+    }
+    return cost;
+}
+
+static void storeColumn(std::vector<uint32_t>& table, uint32_t stride, uint32_t column, const std::vector<uint32_t>& cost) {
+    for (std::size_t v = 0; v < cost.size(); ++v) {
+        table[v * stride + column] = cost[v];
+    }
+}
+
+LandmarkTables buildLandmarks(const RoadGraph& g, uint32_t count, unsigned threads) {
+    LandmarkTables tables;
+    const uint32_t n = g.numNodes();
+    std::vector<uint32_t> candidates;
+    for (uint32_t v = 0; v < n; ++v) {
+        const bool usable = g.component.empty() ? g.first_out[v] != g.first_out[v + 1] : g.component[v] == 0;
+        if (usable) candidates.push_back(v);
+    }
+    if (candidates.empty()) return tables;
+
+    const ReverseAdjacency local_reverse = g.reverse.empty() ? buildReverseAdjacency(g) : ReverseAdjacency();
+    const ReverseAdjacency& reverse = g.reverse.empty() ? local_reverse : g.reverse;
+    count = std::min<uint32_t>(std::clamp(count, min_landmarks, max_landmarks), static_cast<uint32_t>(candidates.size()));
+    const uint32_t stride = (count + landmark_lanes - 1) / landmark_lanes * landmark_lanes;
+    std::vector<uint32_t> from_distance(std::size_t(n) * stride, 0), to_distance(std::size_t(n) * stride, 0);
+    std::vector<uint32_t> from_time(std::size_t(n) * stride, 0), to_time(std::size_t(n) * stride, 0);
+
+    // round trip by length from the landmarks chosen so far; the first is the
+    // node farthest from an arbitrary one
+    std::vector<uint64_t> nearest(n, std::numeric_limits<uint64_t>::max());
+    auto addDistances = [&](const std::vector<uint32_t>& from, const std::vector<uint32_t>& to) {
+        for (uint32_t v : candidates) {
+            nearest[v] = std::min(nearest[v], uint64_t(from[v]) + to[v]);
+        }
+    };
+    auto farthest = [&] {
+        uint32_t best = candidates[0];
+        for (uint32_t v : candidates) {
+            if (nearest[v] > nearest[best]) best = v;
+        }
+        return best;
+    };
+    addDistances(shortestCosts(g, reverse, candidates[0], Metric::distance, false),
+                 shortestCosts(g, reverse, candidates[0], Metric::distance, true));
+
+    std::vector<uint32_t> nodes;
+    for (uint32_t i = 0; i < count; ++i) {
+        const uint32_t landmark = farthest();
+        nodes.push_back(landmark);
+        std::vector<uint32_t> from, to;
+        parallelFor(2, threads, [&](std::size_t begin, std::size_t end) {
+            for (std::size_t side = begin; side < end; ++side) {
+                (side == 0 ? from : to) = shortestCosts(g, reverse, landmark, Metric::distance, side == 1);
+            }
+        });
+        storeColumn(from_distance, stride, i, from);
+        storeColumn(to_distance, stride, i, to);
+        addDistances(from, to);
+    }
+
+    // the travel time tables use the same landmarks; each run fills its own column
+    parallelFor(std::size_t(count) * 2, threads, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t run = begin; run < end; ++run) {
+            const uint32_t i = static_cast<uint32_t>(run / 2);
+            const bool backward = run % 2 == 1;
+            storeColumn(backward ? to_time : from_time, stride, i,
+                        shortestCosts(g, reverse, nodes[i], Metric::time, backward));
+        }
+    });
+
+    tables.count = count;
+    tables.stride = stride;
+    tables.nodes = std::move(nodes);
+    tables.from_distance = std::move(from_distance);
+    tables.to_distance = std::move(to_distance);
+    tables.from_time = std::move(from_time);
+    tables.to_time = std::move(to_time);
+    return tables;
+}
+
+LandmarkTables permuteLandmarks(const LandmarkTables& tables, const std::vector<uint32_t>& order) {
+    LandmarkTables permuted;
+    if (tables.empty()) return permuted;
+    const uint32_t stride = tables.stride;
+    auto permuteRows = [&](const GraphArray<uint32_t>& table) {
+        std::vector<uint32_t> rows(table.size());
+        for (std::size_t i = 0; i < order.size(); ++i) {
+            std::copy(table.begin() + std::size_t(order[i]) * stride, table.begin() + (std::size_t(order[i]) + 1) * stride,
+                      rows.begin() + i * stride);
+        }
+        return rows;
+    };
+    std::vector<uint32_t> rank(order.size());
+    for (std::size_t i = 0; i < order.size(); ++i) {
+        rank[order[i]] = static_cast<uint32_t>(i);
+    }
+    std::vector<uint32_t> nodes;
+    for (uint32_t v : tables.nodes) {
+        nodes.push_back(rank[v]);
+    }
+    permuted.count = tables.count;
+    permuted.stride = stride;
+    permuted.nodes = std::move(nodes);
+    permuted.from_distance = permuteRows(tables.from_distance);
+    permuted.to_distance = permuteRows(tables.to_distance);
+    permuted.from_time = permuteRows(tables.from_time);
+    permuted.to_time = permuteRows(tables.to_time);
+    return permuted;
+}
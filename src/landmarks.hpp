@@ -0,0 +1,106 @@
+#ifndef LANDMARKS
+#define LANDMARKS
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#if defined(__AVX2__) || defined(__SSE4_1__)
+#include <immintrin.h>
+#endif
+
+#include "graph_array.hpp"
+
+struct RoadGraph;
+enum class Metric;
+
+// Distances are padded to a multiple of this many landmarks per node, so the
+// bound below always works on whole 8 x 32-bit vectors
+constexpr uint32_t landmark_lanes = 8;
+
+constexpr uint32_t min_landmarks = 8;
+constexpr uint32_t max_landmarks = 32;
+
+// Entry for nodes a landmark cannot reach or be reached from
+constexpr uint32_t landmark_unreachable = std::numeric_limits<uint32_t>::max();
+
+// Precomputed shortest-path costs between a few landmark nodes and every node,
+// for the ALT lower bound (A*, landmarks, triangle inequality):
+//   cost(v, t) >= cost(L, t) - cost(L, v)  and  cost(v, t) >= cost(v, L) - cost(t, L)
+// Row v of a table holds the costs for node v, landmark i at column i; columns
+// past count are zero. There is one pair of tables per metric.
+//
+// The bound stays a valid lower bound as long as edge costs only go up, so
+// closures and slowdowns need no new tables; new or cheaper roads do.
+struct LandmarkTables {
+    uint32_t count = 0;              // landmarks
+    uint32_t stride = 0;             // count rounded up to landmark_lanes
+    GraphArray<uint32_t> nodes;      // the landmark of each column
+    GraphArray<uint32_t> from_distance; // cost(L, v) by length, numNodes() * stride
+    GraphArray<uint32_t> to_distance;   // cost(v, L) by length
+    GraphArray<uint32_t> from_time;     // the same by travel time
+    GraphArray<uint32_t> to_time;
+
+    bool empty() const { return count == 0; }
+
+    const GraphArray<uint32_t>& from(Metric metric) const;
+    const GraphArray<uint32_t>& to(Metric metric) const;
+};
+
+// Picks count landmarks (clamped to min_landmarks .. max_landmarks) in the
+// giant component by farthest selection: each new one is the node farthest,
+// there and back by length, from those chosen so far. Then runs a forward
+// and a backward Dijkstra per landmark and metric, spread over threads.
+LandmarkTables buildLandmarks(const RoadGraph& g, uint32_t count, unsigned threads);
+
+// Rows of the tables reordered to a new node numbering (see renumberNodes())
+LandmarkTables permuteLandmarks(const LandmarkTables& tables, const std::vector<uint32_t>& order);
+
+// max over the landmarks of both triangle bounds for a node, given its rows
+// and the goal's. stride must be a multiple of landmark_lanes. Unsigned
+// saturating differences stand in for max(a - b, 0), so pass the goal's
+// from-row with unreachable entries zeroed.
+inline uint32_t landmarkBound(const uint32_t* from_v, const uint32_t* to_v,
+                              const uint32_t* from_goal, const uint32_t* to_goal, uint32_t stride) {
+#if defined(__AVX2__)
+    __m256i best = _mm256_setzero_si256();
+    for (uint32_t i = 0; i < stride; i += 8) {
+        const __m256i fv = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(from_v + i));
+        const __m256i fg = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(from_goal + i));
+        const __m256i tv = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(to_v + i));
+        const __m256i tg = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(to_goal + i));
+        const __m256i ahead = _mm256_sub_epi32(_mm256_max_epu32(fg, fv), fv);
+        const __m256i behind = _mm256_sub_epi32(_mm256_max_epu32(tv, tg), tg);
+        best = _mm256_max_epu32(best, _mm256_max_epu32(ahead, behind));
+    }
+    __m128i half = _mm_max_epu32(_mm256_castsi256_si128(best), _mm256_extracti128_si256(best, 1));
+    half = _mm_max_epu32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(1, 0, 3, 2)));
+    half = _mm_max_epu32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(2, 3, 0, 1)));
+    return static_cast<uint32_t>(_mm_cvtsi128_si32(half));
+#elif defined(__SSE4_1__)
+    __m128i best = _mm_setzero_si128();
+    for (uint32_t i = 0; i < stride; i += 4) {
+        const __m128i fv = _mm_loadu_si128(reinterpret_cast<const __m128i*>(from_v + i));
+        const __m128i fg = _mm_loadu_si128(reinterpret_cast<const __m128i*>(from_goal + i));
+        const __m128i tv = _mm_loadu_si128(reinterpret_cast<const __m128i*>(to_v + i));
+        const __m128i tg = _mm_loadu_si128(reinterpret_cast<const __m128i*>(to_goal + i));
+        const __m128i ahead = _mm_sub_epi32(_mm_max_epu32(fg, fv), fv);
+        const __m128i behind = _mm_sub_epi32(_mm_max_epu32(tv, tg), tg);
+        best = _mm_max_epu32(best, _mm_max_epu32(ahead, behind));
+    }
+    best = _mm_max_epu32(best, _mm_shuffle_epi32(best, _MM_SHUFFLE(1, 0, 3, 2)));
+    best = _mm_max_epu32(best, _mm_shuffle_epi32(best, _MM_SHUFFLE(2, 3, 0, 1)));
+    return static_cast<uint32_t>(_mm_cvtsi128_si32(best));
+#else
+    uint32_t best = 0;
+    for (uint32_t i = 0; i < stride; ++i) {
+        const uint32_t ahead = std::max(from_goal[i], from_v[i]) - from_v[i];
+        const uint32_t behind = std::max(to_v[i], to_goal[i]) - to_goal[i];
+        best = std::max(best, std::max(ahead, behind));
+    }
+    return best;
+#endif
+}
+
+#endif
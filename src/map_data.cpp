@@ -9,53 +9,126 @@
 #include <osmium/handler.hpp>
 #include <osmium/visitor.hpp>
 #include <osmium/osm/way.hpp>
-#include <unordered_set>
 #include <unordered_map>
 #include <chrono>
 #include <iomanip>
 #include <sstream>
+#include <algorithm>
+#include <iterator>
+#include <cstdlib>
+#include <osmium/thread/pool.hpp>
+
+#include "osm_pipeline.hpp"
+#include "parallel.hpp"
+#include "region.hpp"
+#include "way_tags.hpp"
 
 // Structure to hold merged road info
 struct Road {
     std::string name;
     std::string type;
     std::vector<std::vector<osmium::object_id_type>> segments; // Each "Way" is one segment
+    std::vector<osmium::object_id_type> way_ids;                // way id of each segment
 };
 
 class MyHandler : public osmium::handler::Handler {
 public:
     std::map<std::pair<std::string, std::string>, Road> mergedRoads;
-    // store node coordinates so we can print lat/lon for nodes referenced in ways
-    std::unordered_map<osmium::object_id_type, std::pair<double, double>> node_coords;
+    // store node coordinates so we can print lat/lon for nodes referenced in ways;
+    // osmium::Location keeps them as 1e-7 degree int32 pairs
+    std::unordered_map<osmium::object_id_type, osmium::Location> node_coords;
+    // which road each matched way went into, so updates can find its segment
+    std::unordered_map<osmium::object_id_type, std::pair<std::string, std::string>> way_roads;
+    // nodes outside are not stored and ways are cut where they leave it
+    Region region;
 
     void node(const osmium::Node& node) {
-        if (node.location().valid()) {
-            node_coords[node.id()] = { node.location().lat(), node.location().lon() };
+        if (region.contains(node.location())) {
+            node_coords[node.id()] = node.location();
         }
     }
 
-    void way(const osmium::Way& way) {
+    // one matched way, tagged with the position of its buffer in the input
+    struct WaySegment {
+        std::size_t sequence;
+        std::pair<std::string, std::string> key;
+        osmium::object_id_type way_id;
+        std::vector<osmium::object_id_type> nodes;
+    };
+
+    // Only reads the way and node_coords, so it can run on several threads at
+    // once after all nodes are stored. With a region, each stretch of the way
+    // with at least two nodes inside becomes a segment of its own.
+    void matchWay(const osmium::Way& way, std::size_t sequence, std::vector<WaySegment>& out) const {
         const char* highway = way.tags()["highway"];
         const char* name = way.tags()["name"];
+        if (!highway || !name) return;
 
-        static const std::unordered_set<std::string> major_roads = {
-            "motorway", "trunk", "primary", "secondary", "tertiary"
-        };
-
-        if (highway && name && major_roads.count(highway)) {
-            std::pair<std::string, std::string> key(name, highway);
-
-            std::vector<osmium::object_id_type> nodes;
+        // major roads only
+        const HighwayClass highway_class = classifyHighway(highway);
+        if (highway_class == HighwayClass::motorway || highway_class == HighwayClass::trunk ||
+            highway_class == HighwayClass::primary || highway_class == HighwayClass::secondary ||
+            highway_class == HighwayClass::tertiary) {
+            WaySegment segment{sequence, {name, highway}, way.id(), {}};
+            auto flush = [&] {
+                if (segment.nodes.size() >= 2) out.push_back(segment);
+                segment.nodes.clear();
+            };
             for (const auto& node_ref : way.nodes()) {
-                nodes.push_back(node_ref.ref());
+                if (!region.empty() && !node_coords.count(node_ref.ref())) {
+                    flush();
+                    continue;
+                }
+                segment.nodes.push_back(node_ref.ref());
             }
-
-            auto& road = mergedRoads[key];
-            if (road.name.empty()) {
-                road.name = name;
-                road.type = highway;
+            if (region.empty()) {
+                out.push_back(std::move(segment));
+            } else {
+                flush();
             }
-            road.segments.push_back(nodes);
+        }
+    }
+
+    void addSegment(WaySegment& segment) {
+        auto& road = mergedRoads[segment.key];
+        if (road.name.empty()) {
+            road.name = segment.key.first;
+            road.type = segment.key.second;
+        }
+        road.segments.push_back(std::move(segment.nodes));
+        road.way_ids.push_back(segment.way_id);
+        way_roads[segment.way_id] = segment.key;
+    }
+
+    // Drops the segments of a way, and the road if they were its last ones
+    void removeWay(osmium::object_id_type way_id) {
+        auto it = way_roads.find(way_id);
+        if (it == way_roads.end()) return;
+        auto road_it = mergedRoads.find(it->second);
+        way_roads.erase(it);
+        if (road_it == mergedRoads.end()) return;
+
+        Road& road = road_it->second;
+        for (std::size_t i = road.way_ids.size(); i-- > 0;) {
+            if (road.way_ids[i] != way_id) continue;
+            road.segments.erase(road.segments.begin() + static_cast<std::ptrdiff_t>(i));
+            road.way_ids.erase(road.way_ids.begin() + static_cast<std::ptrdiff_t>(i));
+        }
+        if (road.segments.empty()) mergedRoads.erase(road_it);
+    }
+
+    // Adds the segments collected by the workers in input order
+    void mergeSegments(std::vector<std::vector<WaySegment>>& per_worker) {
+        std::vector<WaySegment> all;
+        for (auto& part : per_worker) {
+            std::move(part.begin(), part.end(), std::back_inserter(all));
+            part.clear();
+        }
+        std::stable_sort(all.begin(), all.end(), [](const WaySegment& a, const WaySegment& b) {
+            return a.sequence < b.sequence;
+        });
+        for (auto& segment : all) {
+            addSegment(segment);
         }
     }
 
@@ -81,7 +154,7 @@ public:
                         auto it = node_coords.find(nid);
                         if (it != node_coords.end()) {
                             out << "     Node " << nid << " [lat: " << std::fixed << std::setprecision(7)
-                                << it->second.first << ", lon: " << it->second.second << "]\n";
+                                << it->second.lat() << ", lon: " << it->second.lon() << "]\n";
                         } else {
                             out << "     Node " << nid << " [lat/lon: unknown]\n";
                         }
@@ -103,7 +176,7 @@ public:
                             auto it = node_coords.find(nid);
                             if (it != node_coords.end()) {
                                 out << "       " << nid << " [lat: " << std::fixed << std::setprecision(7)
-                                    << it->second.first << ", lon: " << it->second.second << "]\n";
+                                    << it->second.lat() << ", lon: " << it->second.lon() << "]\n";
                             } else {
                                 out << "       " << nid << " [lat/lon: unknown]\n";
                             }
@@ -116,37 +189,100 @@ public:
     }
 };
 
+// the road index built by parseMap, kept so change files can be applied to it
+static MyHandler road_index;
+
+// Writes the road index to a new timestamped txt file under ./data
+static void writeMapData() {
+    auto now = std::chrono::system_clock::now();
+    std::time_t t = std::chrono::system_clock::to_time_t(now);
+    std::stringstream filename;
+    filename << "./data/output_"
+             << std::put_time(std::localtime(&t), "%Y%m%d_%H%M%S")
+             << ".txt";
+
+    std::ofstream outfile(filename.str());
+    if (!outfile) {
+        std::cerr << "Failed to create output file.\n";
+        return;
+    }
+
+    road_index.printMergedData(outfile);
+    outfile.close();
+
+    std::cout << "Map data successfully written to: " << filename.str() << "\n";
+}
+
+// ROUTE_TRACER_REGION (a bbox or a .poly/GeoJSON file) limits the index to one area
 void parseMap() {
     const std::string input_file = "./data/karachi.osm.pbf";
 
     try {
-        osmium::io::Reader reader(input_file);
-        MyHandler handler;
+        const unsigned threads = resolveThreadCount(0);
+        road_index = MyHandler();
+        MyHandler& handler = road_index;
+        if (const char* region = std::getenv("ROUTE_TRACER_REGION")) {
+            handler.region = loadRegion(region);
+            std::cout << "Region: " << handler.region.describe() << "\n";
+        }
+        osmium::thread::Pool pool(static_cast<int>(threads));
+        osmium::io::Reader reader(input_file, osmium::osm_entity_bits::node | osmium::osm_entity_bits::way, pool);
 
-        osmium::apply(reader, handler);
+        // node coordinates are stored on this thread, ways are matched by the workers
+        std::vector<std::vector<MyHandler::WaySegment>> worker_segments(threads);
+        runBufferPipeline(reader, threads,
+            [&](const osmium::memory::Buffer& buffer) {
+                for (const auto& node : buffer.select<osmium::Node>()) {
+                    handler.node(node);
+                }
+                auto ways = buffer.select<osmium::Way>();
+                return ways.begin() != ways.end();
+            },
+            [&](const osmium::memory::Buffer& buffer, std::size_t sequence, unsigned worker) {
+                for (const auto& way : buffer.select<osmium::Way>()) {
+                    handler.matchWay(way, sequence, worker_segments[worker]);
+                }
+            });
         reader.close();
+        handler.mergeSegments(worker_segments);
 
-        // Generate txt file
-        auto now = std::chrono::system_clock::now();
-        std::time_t t = std::chrono::system_clock::to_time_t(now);
-        std::stringstream filename;
-        filename << "./data/output_"
-                 << std::put_time(std::localtime(&t), "%Y%m%d_%H%M%S")
-                 << ".txt";
-
-        std::ofstream outfile(filename.str());
-        if (!outfile) {
-            std::cerr << "Failed to create output file.\n";
-            return;
-        }
+        writeMapData();
+        std::cout << "Map data successfully merged and displayed.\n";
+
+    } catch (const std::exception& e) {
+        std::cerr << "ERROR: " << e.what() << "\n";
+    }
+}
 
-        handler.printMergedData(outfile);
-        outfile.close();
+void applyMapDataChanges(const std::string& osc_file) {
+    try {
+        osmium::io::Reader reader(osc_file, osmium::osm_entity_bits::node | osmium::osm_entity_bits::way);
+        std::size_t way_count = 0;
+        while (osmium::memory::Buffer buffer = reader.read()) {
+            for (const auto& node : buffer.select<osmium::Node>()) {
+                if (node.visible()) {
+                    road_index.node(node);
+                } else {
+                    road_index.node_coords.erase(node.id());
+                }
+            }
 
-        std::cout << "Map data successfully written to: " << filename.str() << "\n";
-        std::cout << "Map data successfully merged and displayed.\n";
+            // a changed way replaces its old segment; deleted ones just go away
+            std::vector<MyHandler::WaySegment> segments;
+            for (const auto& way : buffer.select<osmium::Way>()) {
+                road_index.removeWay(way.id());
+                if (way.visible()) road_index.matchWay(way, 0, segments);
+                way_count++;
+            }
+            for (auto& segment : segments) {
+                road_index.addSegment(segment);
+            }
+        }
+        reader.close();
 
+        std::cout << "Applied " << way_count << " way changes from " << osc_file << " to the road index.\n";
+        writeMapData();
     } catch (const std::exception& e) {
         std::cerr << "ERROR: " << e.what() << "\n";
     }
-}
\ No newline at end of file
+}
@@ -17,4 +17,8 @@
 
 void parseMap();
 
+// Patches the road index built by parseMap with an OsmChange file and writes
+// the updated index to a new output file
+void applyMapDataChanges(const std::string& osc_file);
+
 #endif
\ No newline at end of file
@@ -0,0 +1,43 @@
+#ifndef NODE_COORDS
+#define NODE_COORDS
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "graph_array.hpp"
+
+// Location in degrees, for distance math and output
+struct Node {
+    double lat, lon;
+};
+
+// Graph coordinates are stored in the 1e-7 degree fixed point that
+// osmium::Location uses internally, so values read from OSM convert exactly.
+constexpr double coordinate_precision = 1e7;
+
+inline int32_t toFixed(double degrees) {
+    return static_cast<int32_t>(std::lround(degrees * coordinate_precision));
+}
+
+inline double toDegrees(int32_t fixed) {
+    return fixed / coordinate_precision;
+}
+
+// Node coordinates as two parallel fixed-point arrays, 8 bytes per node.
+// Indexing converts to degrees on the fly.
+struct NodeCoords {
+    GraphArray<int32_t> lat;
+    GraphArray<int32_t> lon;
+
+    NodeCoords() = default;
+    NodeCoords(GraphArray<int32_t> lat_values, GraphArray<int32_t> lon_values)
+        : lat(std::move(lat_values)), lon(std::move(lon_values)) {}
+
+    std::size_t size() const { return lat.size(); }
+    bool empty() const { return lat.empty(); }
+
+    Node operator[](std::size_t v) const { return {toDegrees(lat[v]), toDegrees(lon[v])}; }
+};
+
+#endif
@@ -0,0 +1,31 @@
+#include "node_id_map.hpp"
+
+#include <algorithm>
+#include <numeric>
+#include <utility>
+
+NodeIdMap::NodeIdMap(std::vector<int64_t> osm_ids) {
+    if (!std::is_sorted(osm_ids.begin(), osm_ids.end())) {
+        std::vector<uint32_t> by_id(osm_ids.size());
+        std::iota(by_id.begin(), by_id.end(), 0u);
+        std::sort(by_id.begin(), by_id.end(), [&osm_ids](uint32_t a, uint32_t b) {
+            return osm_ids[a] < osm_ids[b];
+        });
+        m_by_id = std::move(by_id);
+    }
+    // otherwise index order is id order, and lookups search m_osm_ids directly
+    m_osm_ids = std::move(osm_ids);
+}
+
+uint32_t NodeIdMap::indexOf(int64_t osm_id) const {
+    if (m_by_id.empty()) {
+        auto it = std::lower_bound(m_osm_ids.begin(), m_osm_ids.end(), osm_id);
+        if (it == m_osm_ids.end() || *it != osm_id) return invalid_index;
+        return static_cast<uint32_t>(it - m_osm_ids.begin());
+    }
+    auto it = std::lower_bound(m_by_id.begin(), m_by_id.end(), osm_id, [this](uint32_t idx, int64_t id) {
+        return m_osm_ids[idx] < id;
+    });
+    if (it == m_by_id.end() || m_osm_ids[*it] != osm_id) return invalid_index;
+    return *it;
+}
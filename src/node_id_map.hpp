@@ -0,0 +1,39 @@
+#ifndef NODE_ID_MAP
+#define NODE_ID_MAP
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "graph_array.hpp"
+
+// Maps sparse 64-bit OSM node ids to the contiguous 32-bit indices used by the
+// graph, and back. Index i belongs to the i-th id passed to the constructor; the
+// reverse direction is a binary search over the ids in sorted order.
+class NodeIdMap {
+public:
+    static constexpr uint32_t invalid_index = std::numeric_limits<uint32_t>::max();
+
+    NodeIdMap() = default;
+    explicit NodeIdMap(std::vector<int64_t> osm_ids);
+
+    // Wraps arrays that were already prepared, e.g. read back from a snapshot
+    NodeIdMap(GraphArray<int64_t> osm_ids, GraphArray<uint32_t> by_id)
+        : m_osm_ids(std::move(osm_ids)), m_by_id(std::move(by_id)) {}
+
+    uint32_t size() const { return static_cast<uint32_t>(m_osm_ids.size()); }
+
+    int64_t osmId(uint32_t index) const { return m_osm_ids[index]; }
+
+    // Returns invalid_index if the id is not part of the graph.
+    uint32_t indexOf(int64_t osm_id) const;
+
+    const GraphArray<int64_t>& osmIds() const { return m_osm_ids; }
+    const GraphArray<uint32_t>& byId() const { return m_by_id; }
+
+private:
+    GraphArray<int64_t> m_osm_ids; // index -> OSM id
+    GraphArray<uint32_t> m_by_id;  // indices ordered by OSM id; empty if m_osm_ids is already sorted
+};
+
+#endif
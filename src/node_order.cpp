@@ -0,0 +1,206 @@
+#include "node_order.hpp"
+
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+#include <utility>
+
+#include "spatial_index.hpp"
+
+NodeOrder parseNodeOrder(const std::string& name) {
+    if (name == "osm_id") return NodeOrder::osm_id;
+    if (name == "hilbert") return NodeOrder::hilbert;
+    if (name == "bfs") return NodeOrder::bfs;
+    throw std::invalid_argument("unknown node order: " + name);
+}
+
+// Position of (x, y) along the Hilbert curve that fills the 2^32 x 2^32 grid
+static uint64_t hilbertIndex(uint32_t x, uint32_t y) {
+    uint64_t d = 0;
+    for (uint32_t s = 1u << 31; s > 0; s >>= 1) {
+        const uint32_t rx = (x & s) ? 1 : 0;
+        const uint32_t ry = (y & s) ? 1 : 0;
+        d += uint64_t(s) * s * ((3 * rx) ^ ry);
+        // rotate the quadrant so the curve continues where the last one ended
+        if (ry == 0) {
+            if (rx == 1) {
+                x = ~x;
+                y = ~y;
+            }
+            std::swap(x, y);
+        }
+    }
+    return d;
+}
+
+// Stable partition of [0, n) into nodes with edges followed by the rest,
+// each part sorted by key
+template <typename TKey>
+static std::vector<uint32_t> sortedWithEdgesFirst(const std::vector<bool>& used, TKey&& key) {
+    std::vector<uint32_t> order(used.size());
+    std::iota(order.begin(), order.end(), 0);
+    auto mid = std::stable_partition(order.begin(), order.end(), [&used](uint32_t v) { return used[v]; });
+    auto less = [&key](uint32_t a, uint32_t b) { return key(a) < key(b); };
+    std::sort(order.begin(), mid, less);
+    std::sort(mid, order.end(), less);
+    return order;
+}
+
+std::vector<uint32_t> osmIdOrder(const NodeIdMap& node_ids, const std::vector<bool>& used) {
+    return sortedWithEdgesFirst(used, [&node_ids](uint32_t v) { return node_ids.osmId(v); });
+}
+
+std::vector<uint32_t> osmIdOrder(const RoadGraph& g) {
+    return osmIdOrder(g.node_ids, nodesWithEdges(g));
+}
+
+std::vector<uint32_t> hilbertOrder(const NodeCoords& coords, const std::vector<bool>& used) {
+    // shift the signed fixed-point values into unsigned grid coordinates
+    std::vector<uint64_t> keys(coords.size());
+    for (uint32_t v = 0; v < coords.size(); ++v) {
+        keys[v] = hilbertIndex(static_cast<uint32_t>(coords.lon[v]) ^ 0x80000000u,
+                               static_cast<uint32_t>(coords.lat[v]) ^ 0x80000000u);
+    }
+    return sortedWithEdgesFirst(used, [&keys](uint32_t v) { return keys[v]; });
+}
+
+std::vector<uint32_t> hilbertOrder(const RoadGraph& g) {
+    return hilbertOrder(g.coords, nodesWithEdges(g));
+}
+
+std::vector<uint32_t> bfsOrder(const RoadGraph& g, const std::vector<bool>& used) {
+    const uint32_t n = g.numNodes();
+    std::vector<bool> seen(n, false);
+    std::vector<uint32_t> order;
+    order.reserve(n);
+
+    for (uint32_t root = 0; root < n; ++root) {
+        if (seen[root] || !used[root]) continue;
+        seen[root] = true;
+        std::size_t next = order.size();
+        order.push_back(root);
+        while (next < order.size()) {
+            const uint32_t v = order[next++];
+            for (uint32_t e = g.first_out[v]; e < g.first_out[v + 1]; ++e) {
+                if (!seen[g.head[e]]) {
+                    seen[g.head[e]] = true;
+                    order.push_back(g.head[e]);
+                }
+            }
+        }
+    }
+    for (uint32_t v = 0; v < n; ++v) {
+        if (!seen[v]) order.push_back(v);
+    }
+    return order;
+}
+
+std::vector<uint32_t> bfsOrder(const RoadGraph& g) {
+    return bfsOrder(g, nodesWithEdges(g));
+}
+
+NodeCoords permuteCoords(const NodeCoords& coords, const std::vector<uint32_t>& order) {
+    std::vector<int32_t> lat(order.size()), lon(order.size());
+    for (std::size_t i = 0; i < order.size(); ++i) {
+        lat[i] = coords.lat[order[i]];
+        lon[i] = coords.lon[order[i]];
+    }
+    return NodeCoords(std::move(lat), std::move(lon));
+}
+
+NodeIdMap permuteIds(const NodeIdMap& node_ids, const std::vector<uint32_t>& order) {
+    std::vector<int64_t> ids(order.size());
+    for (std::size_t i = 0; i < order.size(); ++i) {
+        ids[i] = node_ids.osmId(order[i]);
+    }
+    return NodeIdMap(std::move(ids));
+}
+
+RoadGraph renumberEdges(RoadGraph g, const std::vector<uint32_t>& order) {
+    const uint32_t n = g.numNodes();
+    std::vector<uint32_t> rank(n);
+    for (uint32_t i = 0; i < n; ++i) {
+        rank[order[i]] = i;
+    }
+
+    const bool has_geometry = !g.geometry_first.empty();
+    std::vector<uint32_t> first_out(n + 1, 0);
+    std::vector<uint32_t> head, length, travel_time, edge_way, geometry_first, geometry;
+    head.reserve(g.numEdges());
+    length.reserve(g.numEdges());
+    travel_time.reserve(g.numEdges());
+    edge_way.reserve(g.numEdges());
+    if (has_geometry) {
+        geometry_first.reserve(g.numEdges() + 1);
+        geometry_first.push_back(0);
+        geometry.reserve(g.geometry.size());
+    }
+    for (uint32_t i = 0; i < n; ++i) {
+        first_out[i] = static_cast<uint32_t>(head.size());
+        const uint32_t v = order[i];
+        for (uint32_t e = g.first_out[v]; e < g.first_out[v + 1]; ++e) {
+            head.push_back(rank[g.head[e]]);
+            length.push_back(g.length[e]);
+            travel_time.push_back(g.travel_time[e]);
+            edge_way.push_back(g.edge_way[e]);
+            if (has_geometry) {
+                for (uint32_t s = g.geometry_first[e]; s < g.geometry_first[e + 1]; ++s) {
+                    geometry.push_back(rank[g.geometry[s]]);
+                }
+                geometry_first.push_back(static_cast<uint32_t>(geometry.size()));
+            }
+        }
+    }
+    first_out[n] = static_cast<uint32_t>(head.size());
+
+    RoadGraph renumbered;
+    renumbered.profile = g.profile;
+    renumbered.first_out = std::move(first_out);
+    renumbered.head = std::move(head);
+    renumbered.length = std::move(length);
+    renumbered.travel_time = std::move(travel_time);
+    renumbered.edge_way = std::move(edge_way);
+    renumbered.geometry_first = std::move(geometry_first);
+    renumbered.geometry = std::move(geometry);
+    renumbered.way_ids = std::move(g.way_ids);
+    renumbered.turn_restrictions = std::move(g.turn_restrictions);
+    if (!g.component.empty()) {
+        std::vector<uint32_t> component(n);
+        for (uint32_t i = 0; i < n; ++i) {
+            component[i] = g.component[order[i]];
+        }
+        renumbered.component = std::move(component);
+        renumbered.component_flags = std::move(g.component_flags);
+    }
+    return renumbered;
+}
+
+RoadGraph renumberNodes(RoadGraph g, const std::vector<uint32_t>& order) {
+    NodeCoords coords = permuteCoords(g.coords, order);
+    NodeIdMap node_ids = permuteIds(g.node_ids, order);
+    const bool had_grid = !g.grid.empty();
+    const double cell_deg = g.grid.params.cell_deg;
+    const uint64_t tile_bytes = g.tiles.tile_bytes;
+    const bool had_adjacency = !g.adjacency.empty();
+    const bool had_reverse = !g.reverse.empty();
+    LandmarkTables landmarks = permuteLandmarks(g.landmarks, order);
+
+    RoadGraph renumbered = renumberEdges(std::move(g), order);
+    renumbered.coords = std::move(coords);
+    renumbered.node_ids = std::move(node_ids);
+    resolveTurnRestrictions(renumbered);
+    if (had_grid) {
+        renumbered.grid = buildSpatialGrid(renumbered, cell_deg);
+    }
+    if (tile_bytes > 0) {
+        renumbered.tiles = buildTileIndex(renumbered, tile_bytes);
+    }
+    if (had_adjacency) {
+        renumbered.adjacency = compressAdjacency(renumbered);
+    }
+    if (had_reverse) {
+        renumbered.reverse = buildReverseAdjacency(renumbered);
+    }
+    renumbered.landmarks = std::move(landmarks);
+    return renumbered;
+}
@@ -0,0 +1,45 @@
+#ifndef NODE_ORDER
+#define NODE_ORDER
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "road_graph.hpp"
+
+// How buildGraphsFromOsm numbers the graph nodes. Searches touch the arrays of
+// nodes that are close on the map together, so numbering them close together
+// keeps those accesses within fewer cache lines and pages.
+enum class NodeOrder {
+    osm_id,  // ascending OSM id, the order the loader produces
+    hilbert, // along a Hilbert curve over the coordinates
+    bfs      // breadth-first from the lowest unvisited node
+};
+
+// "osm_id", "hilbert" or "bfs"; throws std::invalid_argument otherwise
+NodeOrder parseNodeOrder(const std::string& name);
+
+// Each returns order with order[i] = the current index of the node that
+// becomes node i. Nodes with edges come first, so the shape nodes left by
+// contractChains() do not dilute the part the search reads. The variants
+// taking a mask order the node store shared by several graphs, with used[v]
+// set for nodes that have edges in any of them.
+std::vector<uint32_t> osmIdOrder(const RoadGraph& g);
+std::vector<uint32_t> osmIdOrder(const NodeIdMap& node_ids, const std::vector<bool>& used);
+std::vector<uint32_t> hilbertOrder(const RoadGraph& g);
+std::vector<uint32_t> hilbertOrder(const NodeCoords& coords, const std::vector<bool>& used);
+std::vector<uint32_t> bfsOrder(const RoadGraph& g);
+std::vector<uint32_t> bfsOrder(const RoadGraph& g, const std::vector<bool>& used);
+
+// Renumbers all per-node data and edge targets to the given order. The
+// spatial grid and the tile index are rebuilt if the graph had them.
+RoadGraph renumberNodes(RoadGraph g, const std::vector<uint32_t>& order);
+
+// The parts of renumberNodes, for graphs that share their node store:
+// renumberEdges leaves coords and node_ids empty for shareNodes() to fill and
+// builds neither the grid, the tiles nor the turn table.
+NodeCoords permuteCoords(const NodeCoords& coords, const std::vector<uint32_t>& order);
+NodeIdMap permuteIds(const NodeIdMap& node_ids, const std::vector<uint32_t>& order);
+RoadGraph renumberEdges(RoadGraph g, const std::vector<uint32_t>& order);
+
+#endif
@@ -0,0 +1,87 @@
+#include "osm_change.hpp"
+
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <osmium/io/any_input.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/relation.hpp>
+
+#include "road_ways.hpp"
+#include "turn_restrictions.hpp"
+
+GraphChangeSet readOsmChange(const std::string& filename, const GraphOverlay& overlay, const Region& region) {
+    // change files are small; keep them in memory so nodes can be resolved
+    // before ways regardless of their order in the file
+    std::vector<osmium::memory::Buffer> buffers;
+    osmium::io::Reader reader(filename, osmium::osm_entity_bits::node | osmium::osm_entity_bits::way |
+                                            osmium::osm_entity_bits::relation);
+    while (osmium::memory::Buffer buffer = reader.read()) {
+        buffers.push_back(std::move(buffer));
+    }
+    reader.close();
+
+    std::unordered_map<int64_t, const osmium::Node*> nodes;
+    std::unordered_map<int64_t, const osmium::Way*> ways;
+    std::unordered_map<int64_t, const osmium::Relation*> relations;
+    for (const auto& buffer : buffers) {
+        for (const auto& node : buffer.select<osmium::Node>()) {
+            const osmium::Node*& latest = nodes[node.id()];
+            if (!latest || latest->version() <= node.version()) latest = &node;
+        }
+        for (const auto& way : buffer.select<osmium::Way>()) {
+            const osmium::Way*& latest = ways[way.id()];
+            if (!latest || latest->version() <= way.version()) latest = &way;
+        }
+        for (const auto& relation : buffer.select<osmium::Relation>()) {
+            const osmium::Relation*& latest = relations[relation.id()];
+            if (!latest || latest->version() <= relation.version()) latest = &relation;
+        }
+    }
+
+    GraphChangeSet changes;
+    std::unordered_set<int64_t> outside;
+    for (const auto& entry : nodes) {
+        const osmium::Node& node = *entry.second;
+        if (!node.visible()) {
+            changes.deleted_nodes.push_back(node.id());
+        } else if (!node.location().valid()) {
+            continue;
+        } else if (region.contains(node.location())) {
+            changes.node_locations[node.id()] = {node.location().lat(), node.location().lon()};
+        } else {
+            outside.insert(node.id());
+            if (overlay.indexOf(node.id()) != NodeIdMap::invalid_index) changes.deleted_nodes.push_back(node.id());
+        }
+    }
+
+    // ways are cut where they leave the region, as in a full build
+    auto location_of = [&changes, &overlay, &outside](const osmium::NodeRef& node_ref) {
+        if (outside.count(node_ref.ref()) > 0) return osmium::Location();
+        auto it = changes.node_locations.find(node_ref.ref());
+        if (it != changes.node_locations.end()) {
+            return osmium::Location(it->second.lon, it->second.lat);
+        }
+        uint32_t v = overlay.indexOf(node_ref.ref());
+        if (v == NodeIdMap::invalid_index) return osmium::Location();
+        Node c = overlay.coord(v);
+        return osmium::Location(c.lon, c.lat);
+    };
+
+    for (const auto& entry : ways) {
+        const osmium::Way& way = *entry.second;
+        changes.touched_ways.push_back(way.id());
+        if (way.visible()) {
+            emitWayEdges(way, overlay.base().profile, location_of, changes.way_edges);
+        }
+    }
+
+    for (const auto& entry : relations) {
+        const osmium::Relation& relation = *entry.second;
+        changes.touched_relations.push_back(relation.id());
+        if (relation.visible()) {
+            parseTurnRestrictions(relation, overlay.base().profile, changes.turn_restrictions);
+        }
+    }
+    return changes;
+}
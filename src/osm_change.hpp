@@ -0,0 +1,20 @@
+#ifndef OSM_CHANGE
+#define OSM_CHANGE
+
+#include <string>
+
+#include "graph_overlay.hpp"
+#include "region.hpp"
+
+// Reads an OsmChange file (.osc, .osc.gz) into a change set for the road graph.
+// When an object appears several times, its highest version wins. Way node
+// locations come from the change file or else from the current graph; segments
+// whose nodes are known to neither are skipped, as in a full build. Turn
+// restrictions of the relations in the file replace their earlier versions.
+// Node locations outside region are dropped like a build with that region
+// drops them, and graph nodes moved out of it are deleted. Throws on read
+// errors.
+GraphChangeSet readOsmChange(const std::string& filename, const GraphOverlay& overlay,
+                             const Region& region);
+
+#endif
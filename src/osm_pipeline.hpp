@@ -0,0 +1,88 @@
+#ifndef OSM_PIPELINE
+#define OSM_PIPELINE
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <osmium/io/any_input.hpp>
+#include <osmium/memory/buffer.hpp>
+
+// Runs handler work for an OSM file on several threads. The calling thread reads
+// the buffers (decoding itself happens on osmium's thread pool) and passes each
+// one to onRead in file order; that is the place for work that must stay
+// sequential, such as filling a location index. If onRead returns true the
+// buffer is queued and some worker calls process(buffer, sequence, worker),
+// where sequence is the buffer's position in the file and worker is in
+// [0, num_workers). The first exception thrown by a worker is rethrown here.
+template <typename TOnRead, typename TProcess>
+void runBufferPipeline(osmium::io::Reader& reader, unsigned num_workers,
+                       TOnRead&& onRead, TProcess&& process) {
+    std::mutex mutex;
+    std::condition_variable not_empty;
+    std::condition_variable not_full;
+    std::deque<std::pair<std::size_t, osmium::memory::Buffer>> queue;
+    const std::size_t max_queued = num_workers * 2;
+    bool done = false;
+    std::exception_ptr error;
+
+    auto worker = [&](unsigned id) {
+        while (true) {
+            std::pair<std::size_t, osmium::memory::Buffer> item;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                not_empty.wait(lock, [&] { return !queue.empty() || done; });
+                if (queue.empty()) return;
+                item = std::move(queue.front());
+                queue.pop_front();
+                if (error) continue; // just drain the queue
+            }
+            not_full.notify_one();
+            try {
+                process(item.second, item.first, id);
+            } catch (...) {
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    if (!error) error = std::current_exception();
+                }
+                not_full.notify_all();
+            }
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (unsigned i = 0; i < num_workers; ++i) {
+        workers.emplace_back(worker, i);
+    }
+
+    std::size_t sequence = 0;
+    try {
+        while (osmium::memory::Buffer buffer = reader.read()) {
+            if (!onRead(buffer)) continue;
+            std::unique_lock<std::mutex> lock(mutex);
+            not_full.wait(lock, [&] { return queue.size() < max_queued || error; });
+            if (error) break;
+            queue.emplace_back(sequence++, std::move(buffer));
+            lock.unlock();
+            not_empty.notify_one();
+        }
+    } catch (...) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!error) error = std::current_exception();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        done = true;
+    }
+    not_empty.notify_all();
+    for (auto& t : workers) t.join();
+
+    if (error) std::rethrow_exception(error);
+}
+
+#endif
@@ -0,0 +1,97 @@
+#ifndef PARALLEL
+#define PARALLEL
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+// Number of worker threads to use when the caller asked for 0 ("all cores")
+inline unsigned resolveThreadCount(unsigned requested) {
+    if (requested > 0) return requested;
+    unsigned hw = std::thread::hardware_concurrency();
+    return hw > 0 ? hw : 1;
+}
+
+// Splits [0, n) into one contiguous chunk per thread and runs fn(begin, end) on each.
+template <typename TFunc>
+void parallelFor(std::size_t n, unsigned threads, TFunc&& fn) {
+    threads = static_cast<unsigned>(std::max<std::size_t>(1, std::min<std::size_t>(threads, n)));
+    if (threads == 1) {
+        fn(std::size_t(0), n);
+        return;
+    }
+    std::vector<std::thread> pool;
+    std::size_t chunk = (n + threads - 1) / threads;
+    for (unsigned t = 0; t < threads; ++t) {
+        std::size_t begin = std::min(n, t * chunk);
+        std::size_t end = std::min(n, begin + chunk);
+        pool.emplace_back([&fn, begin, end] { fn(begin, end); });
+    }
+    for (auto& th : pool) th.join();
+}
+
+// Stable LSD radix sort by key(element), an unsigned 64-bit integer, one byte
+// per pass. Each thread counts the digits of its chunk; a prefix sum over
+// digits and then threads gives every thread its own output slots, so the
+// scatter needs no locking. Bytes that are the same in every key are skipped,
+// so keys spanning few bits take few passes.
+template <typename T, typename TKey>
+void parallelRadixSort(std::vector<T>& data, TKey key, unsigned threads) {
+    const std::size_t n = data.size();
+    if (n < 2) return;
+    threads = static_cast<unsigned>(std::max<std::size_t>(1, std::min<std::size_t>(threads, n / 65536 + 1)));
+    const std::size_t chunk = (n + threads - 1) / threads;
+
+    // bits in which some key differs from the first
+    std::vector<uint64_t> differ(threads, 0);
+    const uint64_t first_key = key(data[0]);
+    parallelFor(threads, threads, [&](std::size_t first, std::size_t last) {
+        for (std::size_t t = first; t < last; ++t) {
+            uint64_t bits = 0;
+            for (std::size_t i = t * chunk; i < std::min(n, (t + 1) * chunk); ++i) bits |= key(data[i]) ^ first_key;
+            differ[t] = bits;
+        }
+    });
+    uint64_t varying = 0;
+    for (uint64_t bits : differ) varying |= bits;
+
+    std::vector<T> buffer(n);
+    std::vector<std::array<std::size_t, 256>> next(threads);
+    for (unsigned shift = 0; shift < 64; shift += 8) {
+        if (((varying >> shift) & 0xff) == 0) continue;
+        parallelFor(threads, threads, [&](std::size_t first, std::size_t last) {
+            for (std::size_t t = first; t < last; ++t) {
+                next[t].fill(0);
+                for (std::size_t i = t * chunk; i < std::min(n, (t + 1) * chunk); ++i) {
+                    next[t][(key(data[i]) >> shift) & 0xff]++;
+                }
+            }
+        });
+        std::size_t offset = 0;
+        for (std::size_t digit = 0; digit < 256; ++digit) {
+            for (unsigned t = 0; t < threads; ++t) {
+                const std::size_t count = next[t][digit];
+                next[t][digit] = offset;
+                offset += count;
+            }
+        }
+        parallelFor(threads, threads, [&](std::size_t first, std::size_t last) {
+            for (std::size_t t = first; t < last; ++t) {
+                for (std::size_t i = t * chunk; i < std::min(n, (t + 1) * chunk); ++i) {
+                    buffer[next[t][(key(data[i]) >> shift) & 0xff]++] = std::move(data[i]);
+                }
+            }
+        });
+        data.swap(buffer);
+    }
+}
+
+// Radix sort key of a signed id: flipping the sign bit orders negatives first
+inline uint64_t signedKey(int64_t id) {
+    return static_cast<uint64_t>(id) ^ (uint64_t(1) << 63);
+}
+
+#endif
@@ -0,0 +1,203 @@
+// route_tracer_prep: offline preprocessing. Parses an OSM extract, builds the
+// road graph of each profile and its spatial index, and writes the graph snapshot that the
+// router maps at startup. It can also bring an existing snapshot up to date with
+// OsmChange files. Links no windowing or OpenGL code, so it runs on headless
+// build machines.
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+#include "graph_builder.hpp"
+#include "graph_overlay.hpp"
+#include "graph_snapshot.hpp"
+#include "osm_change.hpp"
+#include "parallel.hpp"
+#include "spatial_index.hpp"
+
+static void printUsage(const char* program) {
+    std::cerr << "Usage: " << program << " INPUT.osm.pbf OUTPUT.graph [options]\n"
+              << "       " << program << " --apply-changes BASE.graph OUTPUT.graph CHANGES.osc...\n"
+              << "  --profiles LIST       comma-separated car, bike, foot (default: all three)\n"
+              << "  --bbox BOX            only keep data inside min_lon,min_lat,max_lon,max_lat\n"
+              << "  --polygon FILE        only keep data inside a .poly or GeoJSON boundary\n"
+              << "  --threads N           worker threads (default: all cores)\n"
+              << "  --memory-budget MB    memory for the node location index (default: no limit)\n"
+              << "  --location-index T    libosmium index type, e.g. flex_mem, dense_mmap_array (default: auto)\n"
+              << "  --scratch-dir DIR     where a file-backed location index may be created\n"
+              << "  --single-pass         index all nodes instead of scanning ways first\n"
+              << "  --no-contract         keep every way node as a graph node\n"
+              << "  --no-turn-restrictions  ignore type=restriction relations\n"
+              << "  --min-component N     drop strongly connected components with fewer than N nodes\n"
+              << "  --node-order ORDER    hilbert, bfs or osm_id (default: hilbert)\n"
+              << "  --grid-cell DEG       spatial index cell size in degrees (default: 0.01)\n"
+              << "  --tile-size KB        size of the tiles the router may load on demand, 0 for none (default: 512)\n"
+              << "  --compress-adjacency  also store the edges delta/varint coded; the router then searches those\n"
+              << "  --no-reverse-graph    leave out the in-edges; the router then searches from the start only\n"
+              << "  --landmarks N         store ALT distance tables for N landmarks, 8 to 32 (default: none)\n";
+}
+
+// Applies change files oldest first to the graph of every profile and writes
+// the compacted graphs
+static int applyChanges(const std::string& base_file, const std::string& output_file,
+                        char** osc_files, int count) {
+    try {
+        auto start_time = std::chrono::steady_clock::now();
+        GraphSet base = loadSnapshot(base_file);
+        GraphSet compacted;
+        compacted.region = base.region;
+        const Region region = Region::fromArray(base.region.data(), base.region.size());
+        if (!region.empty()) {
+            std::cout << "Region: " << region.describe() << "\n";
+        }
+        for (const RoadGraph& graph : base.graphs) {
+            GraphOverlay overlay(graph);
+            for (int i = 0; i < count; ++i) {
+                GraphChangeSet changes = readOsmChange(osc_files[i], overlay, region);
+                overlay.apply(changes);
+                std::cout << profileName(graph.profile) << ": applied " << osc_files[i] << ": "
+                          << changes.touched_ways.size() << " ways, " << changes.node_locations.size() << " nodes, "
+                          << changes.touched_relations.size() << " relations\n";
+            }
+            compacted.graphs.push_back(overlay.compact());
+        }
+        writeSnapshot(compacted, output_file);
+        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - start_time);
+        std::cout << "Snapshot written to: " << output_file << " (" << elapsed.count() << " ms)\n";
+        for (const RoadGraph& graph : compacted.graphs) {
+            std::cout << "  " << profileName(graph.profile) << ": road nodes: " << graph.numNodes()
+                      << "  Edges: " << graph.numEdges() << "\n";
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "ERROR: " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc >= 2 && std::string(argv[1]) == "--apply-changes") {
+        if (argc < 5) {
+            printUsage(argv[0]);
+            return 1;
+        }
+        return applyChanges(argv[2], argv[3], argv + 4, argc - 4);
+    }
+    if (argc < 3) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    const std::string input_file = argv[1];
+    const std::string output_file = argv[2];
+    GraphBuildOptions options;
+    double grid_cell = 0.01;
+    uint64_t tile_bytes = default_tile_bytes;
+    bool compress_adjacency = false;
+    bool reverse_graph = true;
+    uint32_t landmarks = 0;
+
+    for (int i = 3; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const bool has_value = i + 1 < argc;
+        if (arg == "--profiles" && has_value) {
+            try {
+                options.profiles = parseProfileList(argv[++i]);
+            } catch (const std::invalid_argument& e) {
+                std::cerr << e.what() << "\n";
+                return 1;
+            }
+        } else if ((arg == "--bbox" || arg == "--polygon") && has_value) {
+            try {
+                options.region = arg == "--bbox" ? parseBbox(argv[++i]) : loadRegion(argv[++i]);
+            } catch (const std::exception& e) {
+                std::cerr << e.what() << "\n";
+                return 1;
+            }
+        } else if (arg == "--threads" && has_value) {
+            options.threads = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--memory-budget" && has_value) {
+            options.memory_budget_mb = static_cast<std::size_t>(std::strtoull(argv[++i], nullptr, 10));
+        } else if (arg == "--location-index" && has_value) {
+            options.location_index = argv[++i];
+        } else if (arg == "--scratch-dir" && has_value) {
+            options.scratch_dir = argv[++i];
+        } else if (arg == "--single-pass") {
+            options.two_pass = false;
+        } else if (arg == "--no-turn-restrictions") {
+            options.turn_restrictions = false;
+        } else if (arg == "--no-contract") {
+            options.contract_chains = false;
+        } else if (arg == "--min-component" && has_value) {
+            options.min_component_size = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--node-order" && has_value) {
+            try {
+                options.node_order = parseNodeOrder(argv[++i]);
+            } catch (const std::invalid_argument& e) {
+                std::cerr << e.what() << "\n";
+                return 1;
+            }
+        } else if (arg == "--grid-cell" && has_value) {
+            grid_cell = std::strtod(argv[++i], nullptr);
+        } else if (arg == "--tile-size" && has_value) {
+            tile_bytes = std::strtoull(argv[++i], nullptr, 10) * 1024;
+        } else if (arg == "--compress-adjacency") {
+            compress_adjacency = true;
+        } else if (arg == "--no-reverse-graph") {
+            reverse_graph = false;
+        } else if (arg == "--landmarks" && has_value) {
+            landmarks = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else {
+            std::cerr << "Unknown option: " << arg << "\n";
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    try {
+        auto start_time = std::chrono::steady_clock::now();
+        auto elapsed = [&start_time] {
+            return std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - start_time).count();
+        };
+
+        GraphSet graphs = buildGraphsFromOsm(input_file, options);
+        std::cout << "Graphs built in " << elapsed() << " ms. Road nodes: " << graphs.graphs[0].numNodes() << "\n";
+        for (RoadGraph& graph : graphs.graphs) {
+            graph.grid = buildSpatialGrid(graph, grid_cell);
+            if (tile_bytes > 0) {
+                graph.tiles = buildTileIndex(graph, tile_bytes);
+            }
+            std::cout << "  " << profileName(graph.profile) << ": edges: " << graph.numEdges()
+                      << "  Components: " << graph.component_flags.size()
+                      << "  Spatial index: " << graph.grid.params.rows << " x " << graph.grid.params.cols << " cells"
+                      << "  Tiles: " << graph.tiles.numTiles() << " (" << graph.tiles.boundary_edges.size()
+                      << " boundary edges)\n";
+            if (reverse_graph) {
+                graph.reverse = buildReverseAdjacency(graph);
+            }
+            if (landmarks > 0) {
+                graph.landmarks = buildLandmarks(graph, landmarks, resolveThreadCount(options.threads));
+                std::cout << "    Landmarks: " << graph.landmarks.count << " ("
+                          << 4 * graph.landmarks.from_distance.size() * sizeof(uint32_t) / 1024 << " KB of tables)\n";
+            }
+            if (compress_adjacency) {
+                graph.adjacency = compressAdjacency(graph);
+                const std::size_t csr_bytes = (graph.first_out.size() + 3 * std::size_t(graph.numEdges())) * sizeof(uint32_t);
+                std::cout << "    Adjacency: " << csr_bytes / 1024 << " KB as CSR, "
+                          << graph.adjacency.memoryBytes() / 1024 << " KB compressed\n";
+            }
+        }
+        std::cout << "Spatial indexes built (" << elapsed() << " ms)\n";
+
+        writeSnapshot(graphs, output_file);
+        std::cout << "Snapshot written to: " << output_file << " (" << elapsed() << " ms total)\n";
+    } catch (const std::exception& e) {
+        std::cerr << "ERROR: " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,49 @@
+#ifndef PROFILE
+#define PROFILE
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Who travels on a graph. Each profile decides which ways it may use, in
+// which direction, and how fast (see road_ways.hpp).
+enum class Profile : uint8_t { car, bike, foot };
+
+inline const char* profileName(Profile profile) {
+    switch (profile) {
+    case Profile::car: return "car";
+    case Profile::bike: return "bike";
+    case Profile::foot: return "foot";
+    }
+    return "unknown";
+}
+
+// Throws std::invalid_argument for unknown names
+inline Profile parseProfile(const std::string& name) {
+    if (name == "car") return Profile::car;
+    if (name == "bike" || name == "bicycle") return Profile::bike;
+    if (name == "foot" || name == "walk") return Profile::foot;
+    throw std::invalid_argument("unknown profile: " + name);
+}
+
+// Comma-separated list such as "car,bike,foot"; duplicates are dropped
+inline std::vector<Profile> parseProfileList(const std::string& list) {
+    std::vector<Profile> profiles;
+    std::size_t begin = 0;
+    while (begin <= list.size()) {
+        std::size_t end = list.find(',', begin);
+        if (end == std::string::npos) end = list.size();
+        if (end > begin) {
+            Profile p = parseProfile(list.substr(begin, end - begin));
+            bool seen = false;
+            for (Profile q : profiles) seen = seen || q == p;
+            if (!seen) profiles.push_back(p);
+        }
+        begin = end + 1;
+    }
+    if (profiles.empty()) throw std::invalid_argument("no profile given");
+    return profiles;
+}
+
+#endif
@@ -0,0 +1,308 @@
+#include "region.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+Region Region::box(const osmium::Location& bottom_left, const osmium::Location& top_right) {
+    Region region;
+    region.m_bounded = true;
+    region.m_min_x = bottom_left.x();
+    region.m_min_y = bottom_left.y();
+    region.m_max_x = top_right.x();
+    region.m_max_y = top_right.y();
+    return region;
+}
+
+Region Region::polygon(const std::vector<std::vector<osmium::Location>>& rings) {
+    Region region;
+    region.m_bounded = true;
+    bool first = true;
+    for (const auto& ring : rings) {
+        if (ring.size() < 3) {
+            throw std::runtime_error("polygon ring with fewer than 3 points");
+        }
+        for (std::size_t i = 0; i < ring.size(); ++i) {
+            const osmium::Location& a = ring[i];
+            const osmium::Location& b = ring[(i + 1) % ring.size()]; // closes open rings
+            if (first) {
+                region.m_min_x = region.m_max_x = a.x();
+                region.m_min_y = region.m_max_y = a.y();
+                first = false;
+            }
+            region.m_min_x = std::min(region.m_min_x, a.x());
+            region.m_max_x = std::max(region.m_max_x, a.x());
+            region.m_min_y = std::min(region.m_min_y, a.y());
+            region.m_max_y = std::max(region.m_max_y, a.y());
+            if (a != b) region.m_edges.push_back({a.x(), a.y(), b.x(), b.y()});
+        }
+        region.m_vertices += static_cast<uint32_t>(ring.size());
+        region.m_rings++;
+    }
+    if (region.m_edges.empty()) {
+        throw std::runtime_error("polygon has no area");
+    }
+    region.indexEdges();
+    return region;
+}
+
+// about eight edges per band on average, counting sort of the edges by band
+void Region::indexEdges() {
+    const int64_t height = int64_t(m_max_y) - m_min_y;
+    const uint32_t bands = static_cast<uint32_t>(std::clamp<std::size_t>(m_edges.size() / 8, 1, 4096));
+    m_band_height = height / bands + 1;
+    auto bandOf = [this](int32_t y) {
+        return static_cast<uint32_t>((int64_t(y) - m_min_y) / m_band_height);
+    };
+    m_band_first.assign(bands + 1, 0);
+    for (const RingEdge& e : m_edges) {
+        for (uint32_t b = bandOf(std::min(e.y1, e.y2)); b <= bandOf(std::max(e.y1, e.y2)); ++b) {
+            m_band_first[b + 1]++;
+        }
+    }
+    for (uint32_t b = 0; b < bands; ++b) {
+        m_band_first[b + 1] += m_band_first[b];
+    }
+    m_band_edges.resize(m_band_first[bands]);
+    std::vector<uint32_t> next(m_band_first.begin(), m_band_first.end() - 1);
+    for (uint32_t i = 0; i < m_edges.size(); ++i) {
+        const RingEdge& e = m_edges[i];
+        for (uint32_t b = bandOf(std::min(e.y1, e.y2)); b <= bandOf(std::max(e.y1, e.y2)); ++b) {
+            m_band_edges[next[b]++] = i;
+        }
+    }
+}
+
+std::vector<int32_t> Region::toArray() const {
+    if (!m_bounded) return {};
+    std::vector<int32_t> values = {m_min_x, m_min_y, m_max_x, m_max_y,
+                                   static_cast<int32_t>(m_rings), static_cast<int32_t>(m_vertices)};
+    for (const RingEdge& e : m_edges) {
+        values.insert(values.end(), {e.x1, e.y1, e.x2, e.y2});
+    }
+    return values;
+}
+
+Region Region::fromArray(const int32_t* values, std::size_t count) {
+    Region region;
+    if (count == 0) return region;
+    if (count < 6 || (count - 6) % 4 != 0 || values[0] > values[2] || values[1] > values[3]) {
+        throw std::runtime_error("malformed stored region");
+    }
+    region.m_bounded = true;
+    region.m_min_x = values[0];
+    region.m_min_y = values[1];
+    region.m_max_x = values[2];
+    region.m_max_y = values[3];
+    region.m_rings = static_cast<uint32_t>(values[4]);
+    region.m_vertices = static_cast<uint32_t>(values[5]);
+    for (std::size_t i = 6; i < count; i += 4) {
+        region.m_edges.push_back({values[i], values[i + 1], values[i + 2], values[i + 3]});
+    }
+    if (!region.m_edges.empty()) region.indexEdges();
+    return region;
+}
+
+// Even-odd rule: count the ring edges crossed by a ray running east from the point
+bool Region::insidePolygon(int32_t x, int32_t y) const {
+    const uint32_t band = static_cast<uint32_t>((int64_t(y) - m_min_y) / m_band_height);
+    bool inside = false;
+    for (uint32_t i = m_band_first[band]; i < m_band_first[band + 1]; ++i) {
+        const RingEdge& e = m_edges[m_band_edges[i]];
+        if ((e.y1 > y) == (e.y2 > y)) continue;
+        const double cross = e.x1 + double(int64_t(y) - e.y1) * (int64_t(e.x2) - e.x1) / double(int64_t(e.y2) - e.y1);
+        if (x < cross) inside = !inside;
+    }
+    return inside;
+}
+
+std::string Region::describe() const {
+    if (!m_bounded) return "everything";
+    std::ostringstream out;
+    if (m_edges.empty()) {
+        out << "box";
+    } else {
+        out << "polygon with " << m_rings << " ring" << (m_rings == 1 ? "" : "s") << " and " << m_vertices << " vertices";
+    }
+    const osmium::Location bottom_left(m_min_x, m_min_y), top_right(m_max_x, m_max_y);
+    out << " " << bottom_left.lon() << "," << bottom_left.lat() << "," << top_right.lon() << "," << top_right.lat();
+    return out.str();
+}
+
+static osmium::Location checkedLocation(double lon, double lat) {
+    const osmium::Location location(lon, lat);
+    if (!location.valid()) {
+        throw std::runtime_error("coordinate out of range: " + std::to_string(lon) + "," + std::to_string(lat));
+    }
+    return location;
+}
+
+Region parseBbox(const std::string& text) {
+    double values[4];
+    const char* p = text.c_str();
+    for (int i = 0; i < 4; ++i) {
+        char* end = nullptr;
+        values[i] = std::strtod(p, &end);
+        if (end == p || (i < 3 && *end != ',') || (i == 3 && *end != '\0')) {
+            throw std::invalid_argument("bbox must be min_lon,min_lat,max_lon,max_lat: " + text);
+        }
+        p = end + 1;
+    }
+    if (!(values[0] < values[2] && values[1] < values[3])) {
+        throw std::invalid_argument("bbox is empty: " + text);
+    }
+    try {
+        return Region::box(checkedLocation(values[0], values[1]), checkedLocation(values[2], values[3]));
+    } catch (const std::runtime_error& e) {
+        throw std::invalid_argument(e.what());
+    }
+}
+
+static std::string readFile(const std::string& filename) {
+    std::ifstream in(filename, std::ios::binary);
+    if (!in) {
+        throw std::runtime_error("cannot open region file " + filename);
+    }
+    std::ostringstream text;
+    text << in.rdbuf();
+    return text.str();
+}
+
+Region readPolyFile(const std::string& filename) {
+    std::istringstream in(readFile(filename));
+    std::string line;
+    std::getline(in, line); // polygon name
+    std::vector<std::vector<osmium::Location>> rings;
+    while (std::getline(in, line)) {
+        const std::size_t start = line.find_first_not_of(" \t\r");
+        if (start == std::string::npos) continue;
+        if (line.compare(start, 3, "END") == 0) break; // end of file
+        // a section header: its name, '!' marking a hole, which even-odd handles
+        std::vector<osmium::Location> ring;
+        bool closed = false;
+        while (std::getline(in, line)) {
+            std::istringstream fields(line);
+            std::string first;
+            if (!(fields >> first)) continue;
+            if (first == "END") {
+                closed = true;
+                break;
+            }
+            double lon = 0, lat = 0;
+            std::istringstream number(first);
+            if (!(number >> lon) || !(fields >> lat)) {
+                throw std::runtime_error("bad coordinate line in " + filename + ": " + line);
+            }
+            ring.push_back(checkedLocation(lon, lat));
+        }
+        if (!closed) {
+            throw std::runtime_error("unterminated section in " + filename);
+        }
+        rings.push_back(std::move(ring));
+    }
+    if (rings.empty()) {
+        throw std::runtime_error("no polygon in " + filename);
+    }
+    return Region::polygon(rings);
+}
+
+// Nested JSON arrays of numbers, as GeoJSON coordinates are written
+struct JsonArray {
+    std::vector<JsonArray> items;
+    std::vector<double> numbers;
+};
+
+static void skipSpace(const std::string& text, std::size_t& pos) {
+    while (pos < text.size() && std::isspace(static_cast<unsigned char>(text[pos]))) ++pos;
+}
+
+static JsonArray parseJsonArray(const std::string& text, std::size_t& pos, int depth) {
+    skipSpace(text, pos);
+    if (pos >= text.size() || text[pos] != '[' || depth > 8) {
+        throw std::runtime_error("malformed GeoJSON coordinates");
+    }
+    ++pos;
+    JsonArray array;
+    skipSpace(text, pos);
+    if (pos < text.size() && text[pos] == ']') {
+        ++pos;
+        return array;
+    }
+    while (true) {
+        skipSpace(text, pos);
+        if (pos < text.size() && text[pos] == '[') {
+            array.items.push_back(parseJsonArray(text, pos, depth + 1));
+        } else {
+            char* end = nullptr;
+            const double value = std::strtod(text.c_str() + pos, &end);
+            if (end == text.c_str() + pos) {
+                throw std::runtime_error("malformed GeoJSON coordinates");
+            }
+            array.numbers.push_back(value);
+            pos = static_cast<std::size_t>(end - text.c_str());
+        }
+        skipSpace(text, pos);
+        if (pos < text.size() && text[pos] == ',') {
+            ++pos;
+        } else if (pos < text.size() && text[pos] == ']') {
+            ++pos;
+            return array;
+        } else {
+            throw std::runtime_error("malformed GeoJSON coordinates");
+        }
+    }
+}
+
+// Polygon coordinates are rings of points and MultiPolygon ones polygons of
+// rings; either way every array whose items are points is a ring
+static void collectRings(const JsonArray& array, std::vector<std::vector<osmium::Location>>& rings) {
+    if (array.items.empty()) return;
+    if (array.items[0].items.empty()) {
+        std::vector<osmium::Location> ring;
+        for (const JsonArray& point : array.items) {
+            if (point.numbers.size() < 2) {
+                throw std::runtime_error("GeoJSON position needs longitude and latitude");
+            }
+            ring.push_back(checkedLocation(point.numbers[0], point.numbers[1]));
+        }
+        // GeoJSON repeats the first position at the end
+        if (ring.size() > 1 && ring.front() == ring.back()) ring.pop_back();
+        rings.push_back(std::move(ring));
+        return;
+    }
+    for (const JsonArray& item : array.items) {
+        collectRings(item, rings);
+    }
+}
+
+Region readGeoJsonRegion(const std::string& filename) {
+    const std::string text = readFile(filename);
+    std::size_t pos = text.find("\"coordinates\"");
+    if (pos == std::string::npos) {
+        throw std::runtime_error("no coordinates in " + filename);
+    }
+    pos = text.find(':', pos);
+    if (pos == std::string::npos) {
+        throw std::runtime_error("malformed GeoJSON in " + filename);
+    }
+    ++pos;
+    std::vector<std::vector<osmium::Location>> rings;
+    collectRings(parseJsonArray(text, pos, 0), rings);
+    if (rings.empty()) {
+        throw std::runtime_error("no polygon in " + filename);
+    }
+    return Region::polygon(rings);
+}
+
+static bool endsWith(const std::string& text, const std::string& suffix) {
+    return text.size() >= suffix.size() && text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+Region loadRegion(const std::string& spec) {
+    if (endsWith(spec, ".poly")) return readPolyFile(spec);
+    if (endsWith(spec, ".geojson") || endsWith(spec, ".json")) return readGeoJsonRegion(spec);
+    return parseBbox(spec);
+}
@@ -0,0 +1,83 @@
+#ifndef REGION
+#define REGION
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <osmium/osm/location.hpp>
+
+// Area the loaders keep data from, so a worker for one city can be fed from a
+// regional extract. Nodes outside are dropped as they are read; a way that
+// crosses the boundary keeps its segments between inside nodes and is cut at
+// the last node before it leaves. A default-constructed region keeps
+// everything.
+//
+// Polygons may have several rings; a point is inside if it lies within an odd
+// number of them, so holes and multipolygons need no extra bookkeeping. The
+// ring edges are bucketed into horizontal bands, so a lookup only looks at
+// the edges near the point's latitude.
+class Region {
+public:
+    Region() = default;
+
+    static Region box(const osmium::Location& bottom_left, const osmium::Location& top_right);
+    static Region polygon(const std::vector<std::vector<osmium::Location>>& rings);
+
+    // true if the region keeps everything
+    bool empty() const { return !m_bounded; }
+
+    // false for invalid locations, even if the region keeps everything
+    bool contains(const osmium::Location& location) const {
+        if (!location.valid()) return false;
+        if (!m_bounded) return true;
+        const int32_t x = location.x();
+        const int32_t y = location.y();
+        if (x < m_min_x || x > m_max_x || y < m_min_y || y > m_max_y) return false;
+        return m_edges.empty() || insidePolygon(x, y);
+    }
+
+    // "box", or the polygon's number of rings and vertices, for log output
+    std::string describe() const;
+
+    // The region as plain numbers, for storing it with the graphs it was
+    // built for: empty if it keeps everything, else the bounding box, the
+    // number of rings and vertices and the ring edges, in osmium fixed point
+    std::vector<int32_t> toArray() const;
+    // Throws std::runtime_error if values is not something toArray() returned
+    static Region fromArray(const int32_t* values, std::size_t count);
+
+private:
+    struct RingEdge {
+        int32_t x1, y1, x2, y2;
+    };
+
+    void indexEdges();
+    bool insidePolygon(int32_t x, int32_t y) const;
+
+    bool m_bounded = false;
+    int32_t m_min_x = 0, m_min_y = 0, m_max_x = 0, m_max_y = 0;
+    std::vector<RingEdge> m_edges;        // empty for a plain box
+    uint32_t m_vertices = 0, m_rings = 0;
+    int64_t m_band_height = 1;
+    std::vector<uint32_t> m_band_first;   // bands + 1 offsets into m_band_edges
+    std::vector<uint32_t> m_band_edges;   // indices into m_edges
+};
+
+// "min_lon,min_lat,max_lon,max_lat" as osmium and osmconvert take it.
+// Throws std::invalid_argument if it is malformed or empty.
+Region parseBbox(const std::string& text);
+
+// Osmosis polygon filter file (.poly); sections named with a leading '!' are
+// holes. Throws std::runtime_error on I/O or format errors.
+Region readPolyFile(const std::string& filename);
+
+// GeoJSON file holding a Polygon or MultiPolygon, bare or inside a Feature or
+// FeatureCollection; the first "coordinates" member is used. Throws
+// std::runtime_error on I/O or format errors.
+Region readGeoJsonRegion(const std::string& filename);
+
+// A .poly or .geojson/.json file by extension, otherwise a bbox
+Region loadRegion(const std::string& spec);
+
+#endif
@@ -0,0 +1,33 @@
+#include "reverse_adjacency.hpp"
+
+#include <utility>
+#include <vector>
+
+#include "road_graph.hpp"
+
+ReverseAdjacency buildReverseAdjacency(const RoadGraph& g) {
+    const uint32_t n = g.numNodes();
+    std::vector<uint32_t> first_in(n + 1, 0);
+    for (uint32_t e = 0; e < g.numEdges(); ++e) {
+        first_in[g.head[e] + 1]++;
+    }
+    for (uint32_t v = 0; v < n; ++v) {
+        first_in[v + 1] += first_in[v];
+    }
+
+    std::vector<uint32_t> tail(g.numEdges()), in_edge(g.numEdges());
+    std::vector<uint32_t> next(first_in.begin(), first_in.end() - 1);
+    for (uint32_t u = 0; u < n; ++u) {
+        for (uint32_t e = g.first_out[u]; e < g.first_out[u + 1]; ++e) {
+            const uint32_t slot = next[g.head[e]]++;
+            tail[slot] = u;
+            in_edge[slot] = e;
+        }
+    }
+
+    ReverseAdjacency reverse;
+    reverse.first_in = std::move(first_in);
+    reverse.tail = std::move(tail);
+    reverse.in_edge = std::move(in_edge);
+    return reverse;
+}
@@ -0,0 +1,26 @@
+#ifndef REVERSE_ADJACENCY
+#define REVERSE_ADJACENCY
+
+#include <cstdint>
+
+#include "graph_array.hpp"
+
+struct RoadGraph;
+
+// In-edges of every node, for searches that run backwards from the goal
+// (bidirectionalAstar). The edges into node v are listed at positions
+// first_in[v] .. first_in[v + 1] - 1: tail names the node they leave from and
+// in_edge their index in the forward arrays, where the weights stay, so
+// updated costs need no second copy.
+struct ReverseAdjacency {
+    GraphArray<uint32_t> first_in; // numNodes() + 1 offsets
+    GraphArray<uint32_t> tail;
+    GraphArray<uint32_t> in_edge;
+
+    bool empty() const { return first_in.empty(); }
+};
+
+// Counting sort of the edges of g by target
+ReverseAdjacency buildReverseAdjacency(const RoadGraph& g);
+
+#endif
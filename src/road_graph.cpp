@@ -0,0 +1,98 @@
+#include "road_graph.hpp"
+
+#include <algorithm>
+#include <utility>
+
+#include "parallel.hpp"
+
+uint32_t RoadGraph::findEdge(uint32_t u, uint32_t v, Metric metric) const {
+    const GraphArray<uint32_t>& weight = weights(metric);
+    uint32_t best = NodeIdMap::invalid_index;
+    for (uint32_t e = first_out[u]; e < first_out[u + 1]; ++e) {
+        if (head[e] == v && (best == NodeIdMap::invalid_index || weight[e] < weight[best])) best = e;
+    }
+    return best;
+}
+
+std::size_t normalizeEdges(std::vector<GraphEdge>& edges, unsigned threads) {
+    parallelRadixSort(edges, [](const GraphEdge& e) {
+        return uint64_t(e.from) << 32 | e.to;
+    }, threads);
+
+    // runs of parallel edges are short; sort each by way and keep the edges no
+    // other edge of the same way beats in both length and time. Edges of
+    // different ways all stay: an update may delete one way, and turn
+    // restrictions name the way an edge belongs to.
+    auto byCost = [](const GraphEdge& a, const GraphEdge& b) {
+        if (a.length != b.length) return a.length < b.length;
+        if (a.time != b.time) return a.time < b.time;
+        return a.way < b.way;
+    };
+    const std::size_t before = edges.size();
+    std::size_t out = 0;
+    for (std::size_t first = 0; first < edges.size();) {
+        std::size_t last = first + 1;
+        while (last < edges.size() && edges[last].from == edges[first].from && edges[last].to == edges[first].to) ++last;
+        if (edges[first].from == edges[first].to) {
+            first = last;
+            continue;
+        }
+        std::sort(edges.begin() + first, edges.begin() + last, [&byCost](const GraphEdge& a, const GraphEdge& b) {
+            return a.way != b.way ? a.way < b.way : byCost(a, b);
+        });
+        // in length order an edge survives only if it is quicker than all
+        // before it of its way
+        const std::size_t run_out = out;
+        uint32_t way = edges[first].way;
+        uint32_t best_time = 0;
+        for (std::size_t i = first; i < last; ++i) {
+            if (i > first && edges[i].way == way && edges[i].time >= best_time) continue;
+            way = edges[i].way;
+            best_time = edges[i].time;
+            edges[out++] = edges[i];
+        }
+        std::sort(edges.begin() + run_out, edges.begin() + out, byCost);
+        first = last;
+    }
+    edges.resize(out);
+    return before - out;
+}
+
+RoadGraph buildRoadGraph(NodeCoords coords, NodeIdMap node_ids,
+                         std::vector<int64_t> way_ids, const std::vector<GraphEdge>& edges) {
+    const uint32_t n = static_cast<uint32_t>(coords.size());
+
+    // count out-degrees, then prefix-sum them into offsets
+    std::vector<uint32_t> first_out(n + 1, 0);
+    for (const auto& e : edges) {
+        first_out[e.from + 1]++;
+    }
+    for (uint32_t v = 0; v < n; ++v) {
+        first_out[v + 1] += first_out[v];
+    }
+
+    // scatter edges into their slots; insert position per node starts at its offset
+    std::vector<uint32_t> head(edges.size());
+    std::vector<uint32_t> length(edges.size());
+    std::vector<uint32_t> travel_time(edges.size());
+    std::vector<uint32_t> edge_way(edges.size());
+    std::vector<uint32_t> next(first_out.begin(), first_out.end() - 1);
+    for (const auto& e : edges) {
+        uint32_t slot = next[e.from]++;
+        head[slot] = e.to;
+        length[slot] = e.length;
+        travel_time[slot] = e.time;
+        edge_way[slot] = e.way;
+    }
+
+    RoadGraph graph;
+    graph.first_out = std::move(first_out);
+    graph.head = std::move(head);
+    graph.length = std::move(length);
+    graph.travel_time = std::move(travel_time);
+    graph.edge_way = std::move(edge_way);
+    graph.way_ids = std::move(way_ids);
+    graph.coords = std::move(coords);
+    graph.node_ids = std::move(node_ids);
+    return graph;
+}
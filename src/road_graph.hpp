@@ -0,0 +1,168 @@
+#ifndef ROAD_GRAPH
+#define ROAD_GRAPH
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "compressed_adjacency.hpp"
+#include "graph_array.hpp"
+#include "graph_tiles.hpp"
+#include "landmarks.hpp"
+#include "node_coords.hpp"
+#include "node_id_map.hpp"
+#include "profile.hpp"
+#include "reverse_adjacency.hpp"
+#include "spatial_index.hpp"
+#include "turn_restrictions.hpp"
+
+// Edge costs are integers: length in decimetres and travel time in
+// deciseconds. Both are rounded up, so straight-line distance divided by the
+// top speed never overestimates either of them.
+enum class Metric { distance, time };
+
+// speeds above this are clamped; it bounds the travel-time heuristic
+constexpr double max_road_speed_kmh = 130.0;
+
+inline uint32_t lengthUnits(double meters) {
+    return static_cast<uint32_t>(std::ceil(meters * 10.0));
+}
+
+inline uint32_t timeUnits(double meters, double speed_kmh) {
+    return static_cast<uint32_t>(std::ceil(meters * 36.0 / speed_kmh));
+}
+
+// Lower bound for the cost of covering a straight-line distance
+inline uint32_t costLowerBound(Metric metric, double meters) {
+    return static_cast<uint32_t>(metric == Metric::time ? meters * 36.0 / max_road_speed_kmh : meters * 10.0);
+}
+
+struct EdgeCost {
+    uint32_t length; // decimetres
+    uint32_t time;   // deciseconds
+};
+
+// Road edge keyed by OSM ids, as read from the input before node indices exist
+struct OsmEdge {
+    int64_t from, to;
+    uint32_t length, time;
+    int64_t way;
+};
+
+// Edge as emitted by the loader, before the graph is frozen.
+struct GraphEdge {
+    uint32_t from;
+    uint32_t to;
+    uint32_t length;
+    uint32_t time;
+    uint32_t way; // index into the way id table
+};
+
+// Frozen road graph in compressed sparse row form. The out-edges of node v are
+// the entries first_out[v] .. first_out[v + 1] - 1 of the edge arrays. The arrays
+// are either owned or views into a mapped snapshot kept alive by storage.
+//
+// After contractChains() an edge may stand for a whole chain of road segments;
+// the nodes it passes are listed in geometry[geometry_first[e] ..
+// geometry_first[e + 1] - 1] and are only needed when a path is output.
+//
+// Searches are written against the small interface at the bottom (numNodes,
+// coord, forEachOutEdge), which GraphOverlay provides as well. Functions that
+// rebuild the edge arrays carry turn_restrictions over and rebuild turns.
+struct RoadGraph {
+    Profile profile = Profile::car;
+    GraphArray<uint32_t> first_out; // numNodes() + 1 entries
+    GraphArray<uint32_t> head;      // target node of each edge
+    GraphArray<uint32_t> length;    // decimetres
+    GraphArray<uint32_t> travel_time; // deciseconds
+    GraphArray<uint32_t> edge_way;  // index into way_ids for each edge
+    GraphArray<int64_t> way_ids;    // sorted OSM ids of the ways that produced edges
+    GraphArray<uint32_t> geometry_first; // numEdges() + 1 entries, empty if not contracted
+    GraphArray<uint32_t> geometry;       // shape nodes inside each edge, in travel order
+    GraphArray<uint32_t> component;      // strongly connected component per node, see components.hpp
+    GraphArray<uint8_t> component_flags; // per component
+    GraphArray<TurnRestriction> turn_restrictions; // in OSM ids, see turn_restrictions.hpp
+    TurnTable turns;                     // turn_restrictions resolved against the edges
+    NodeCoords coords;              // indexed by dense node index
+    NodeIdMap node_ids;             // dense node index <-> OSM node id
+    SpatialGrid grid;               // optional, for snapping coordinates to nodes
+    TileIndex tiles;                // optional, for loading the graph in parts (TiledGraph)
+    CompressedAdjacency adjacency;  // optional, for searching in less memory (CompressedGraph)
+    ReverseAdjacency reverse;       // optional, for searching from the goal (bidirectionalAstar)
+    LandmarkTables landmarks;       // optional, for the ALT lower bound (altAstar)
+
+    std::shared_ptr<const void> storage; // owner of borrowed arrays (snapshot mapping, shared node store)
+
+    uint32_t numNodes() const { return static_cast<uint32_t>(coords.size()); }
+    uint32_t numEdges() const { return static_cast<uint32_t>(head.size()); }
+
+    Node coord(uint32_t v) const { return coords[v]; }
+    int64_t osmId(uint32_t v) const { return node_ids.osmId(v); }
+
+    const GraphArray<uint32_t>& weights(Metric metric) const {
+        return metric == Metric::time ? travel_time : length;
+    }
+
+    // cheapest edge from u to v, NodeIdMap::invalid_index if there is none
+    uint32_t findEdge(uint32_t u, uint32_t v, Metric metric = Metric::distance) const;
+
+    // f(to, weight) for every out-edge of v, weighted by the given metric
+    template <typename F>
+    void forEachOutEdge(uint32_t v, Metric metric, F&& f) const {
+        const GraphArray<uint32_t>& weight = weights(metric);
+        for (uint32_t e = first_out[v]; e < first_out[v + 1]; ++e) {
+            f(head[e], weight[e]);
+        }
+    }
+
+    // f(e, to, weight), the same with the edge index, for searches that look
+    // edges up in the turn table
+    template <typename F>
+    void forEachOutEdgeIndexed(uint32_t v, Metric metric, F&& f) const {
+        const GraphArray<uint32_t>& weight = weights(metric);
+        for (uint32_t e = first_out[v]; e < first_out[v + 1]; ++e) {
+            f(e, head[e], weight[e]);
+        }
+    }
+};
+
+// A RoadGraph searched through its compressed adjacency, which must not be
+// empty. head, length and travel_time are never read, so with a mapped
+// snapshot their pages stay on disk; the cost is decoding a few bytes per
+// edge. Path output goes through the RoadGraph itself.
+class CompressedGraph {
+public:
+    explicit CompressedGraph(const RoadGraph& g) : m_graph(g) {}
+
+    uint32_t numNodes() const { return m_graph.numNodes(); }
+    Node coord(uint32_t v) const { return m_graph.coord(v); }
+
+    template <typename F>
+    void forEachOutEdge(uint32_t v, Metric metric, F&& f) const {
+        const bool by_time = metric == Metric::time;
+        m_graph.adjacency.decode(v, [&f, by_time](uint32_t to, uint32_t length, uint32_t time) {
+            f(to, by_time ? time : length);
+        });
+    }
+
+private:
+    const RoadGraph& m_graph;
+};
+
+// Sorts edges by source, then target, with a parallel radix sort, and drops
+// self-loops and every parallel edge that is neither shorter nor quicker than
+// another one of the same way between the same nodes. Parallel edges of
+// different ways are all kept, since GraphOverlay drops edges by way and turn
+// restrictions match them by way. The parallel edges left are ordered by
+// length, time and way, so the result does not depend on the input order.
+// Returns the number of edges dropped.
+std::size_t normalizeEdges(std::vector<GraphEdge>& edges, unsigned threads);
+
+// Freezes an unordered edge list into CSR arrays (counting sort by source).
+// GraphEdge::way indexes way_ids, which must be sorted.
+RoadGraph buildRoadGraph(NodeCoords coords, NodeIdMap node_ids,
+                         std::vector<int64_t> way_ids, const std::vector<GraphEdge>& edges);
+
+#endif
@@ -0,0 +1,132 @@
+#include "road_ways.hpp"
+
+#include <algorithm>
+
+enum class BikeAccess : uint8_t { no, yes, if_signed };
+
+// What each profile makes of a highway class
+struct HighwayRules {
+    bool car;             // drivable
+    uint8_t car_kmh;      // typical free-flow car speed
+    BikeAccess bike;      // if_signed: only with bicycle=yes/designated/permissive
+    bool foot;            // walkable without a foot tag
+};
+
+// indexed by HighwayClass
+constexpr HighwayRules highway_rules[] = {
+    {false, 25, BikeAccess::no, false},        // none
+    {true, 90, BikeAccess::no, false},         // motorway
+    {true, 45, BikeAccess::no, false},         // motorway_link
+    {true, 85, BikeAccess::if_signed, false},  // trunk
+    {false, 40, BikeAccess::if_signed, false}, // trunk_link
+    {true, 65, BikeAccess::yes, true},         // primary
+    {true, 30, BikeAccess::yes, true},         // primary_link
+    {true, 55, BikeAccess::yes, true},         // secondary
+    {true, 25, BikeAccess::yes, true},         // secondary_link
+    {true, 40, BikeAccess::yes, true},         // tertiary
+    {true, 20, BikeAccess::yes, true},         // tertiary_link
+    {true, 25, BikeAccess::yes, true},         // unclassified
+    {true, 25, BikeAccess::yes, true},         // residential
+    {true, 10, BikeAccess::yes, true},         // living_street
+    {true, 15, BikeAccess::yes, true},         // service
+    {false, 25, BikeAccess::yes, true},        // road
+    {false, 25, BikeAccess::yes, true},        // track
+    {false, 25, BikeAccess::yes, true},        // path
+    {false, 25, BikeAccess::yes, true},        // cycleway
+    {false, 25, BikeAccess::if_signed, true},  // footway
+    {false, 25, BikeAccess::if_signed, true},  // pedestrian
+    {false, 25, BikeAccess::no, true},         // steps
+    {false, 25, BikeAccess::if_signed, true},  // bridleway
+    {false, 25, BikeAccess::no, true},         // corridor
+    {false, 25, BikeAccess::no, false},        // other
+};
+static_assert(sizeof(highway_rules) / sizeof(highway_rules[0]) == static_cast<std::size_t>(HighwayClass::other) + 1,
+              "one rule per highway class");
+
+static const HighwayRules& rulesFor(HighwayClass highway) {
+    return highway_rules[static_cast<std::size_t>(highway)];
+}
+
+// car: the drivable highway classes, access and motor_vehicle restrictions
+static WayDirection carDirection(const WayAttributes& way) {
+    if (!rulesFor(way.highway).car) return WayDirection::none;
+    if (way.access == TagAccess::denied || way.motor_vehicle == TagAccess::denied) {
+        return WayDirection::none; // not allowed for motor vehicles
+    }
+    if (way.oneway == TagOneway::backward) return WayDirection::backward;
+    if (way.oneway == TagOneway::forward || way.roundabout) return WayDirection::forward;
+    return WayDirection::both;
+}
+
+// numeric maxspeed if there is one, otherwise a default for the highway class
+static double carSpeedKmh(const WayAttributes& way) {
+    double speed = way.maxspeed > 0 ? way.maxspeed / 10.0 : rulesFor(way.highway).car_kmh;
+    return std::min(std::max(speed, 5.0), max_road_speed_kmh);
+}
+
+// bicycles: cycleways and paths plus the ordinary road network below
+// motorways; footways and pedestrian zones only where bicycles are signed
+static WayDirection bikeDirection(const WayAttributes& way) {
+    const bool bicycle_allowed = way.bicycle == TagAccess::allowed;
+    const BikeAccess rule = rulesFor(way.highway).bike;
+    if (rule == BikeAccess::no || (rule == BikeAccess::if_signed && !bicycle_allowed)) return WayDirection::none;
+    if (way.bicycle == TagAccess::denied || (way.access == TagAccess::denied && !bicycle_allowed)) {
+        return WayDirection::none;
+    }
+
+    // one-way streets bind cyclists too, unless they are exempted
+    if (way.bike_contraflow) return WayDirection::both;
+    if (way.oneway == TagOneway::backward) return WayDirection::backward;
+    if (way.oneway == TagOneway::forward || way.roundabout) return WayDirection::forward;
+    return WayDirection::both;
+}
+
+static double bikeSpeedKmh(const WayAttributes& way) {
+    switch (way.highway) {
+    case HighwayClass::cycleway: return 18;
+    case HighwayClass::track:
+    case HighwayClass::path: return 12;
+    case HighwayClass::footway:
+    case HighwayClass::pedestrian: return 8;
+    default: return 15;
+    }
+}
+
+// pedestrians: everything walkable, in both directions; motorways and trunk
+// roads only where foot access is signed
+static WayDirection footDirection(const WayAttributes& way) {
+    if (way.highway == HighwayClass::none) return WayDirection::none;
+    const bool foot_allowed = way.foot == TagAccess::allowed;
+    if (!rulesFor(way.highway).foot && !foot_allowed) return WayDirection::none;
+    if (way.foot == TagAccess::denied || (way.access == TagAccess::denied && !foot_allowed)) {
+        return WayDirection::none;
+    }
+    if (way.foot_oneway) return WayDirection::forward;
+    return WayDirection::both;
+}
+
+static double footSpeedKmh(const WayAttributes& way) {
+    return way.highway == HighwayClass::steps ? 2 : 5;
+}
+
+WayDirection roadDirection(const WayAttributes& way, Profile profile) {
+    switch (profile) {
+    case Profile::car: return carDirection(way);
+    case Profile::bike: return bikeDirection(way);
+    case Profile::foot: return footDirection(way);
+    }
+    return WayDirection::none;
+}
+
+double roadSpeedKmh(const WayAttributes& way, Profile profile) {
+    switch (profile) {
+    case Profile::car: return carSpeedKmh(way);
+    case Profile::bike: return bikeSpeedKmh(way);
+    case Profile::foot: return footSpeedKmh(way);
+    }
+    return 5;
+}
+
+WayDirection roadDirection(const osmium::Way& way, Profile profile) {
+    return roadDirection(classifyWay(way.tags()), profile);
+}
@@ -0,0 +1,71 @@
+#ifndef ROAD_WAYS
+#define ROAD_WAYS
+
+#include <cstdint>
+#include <iterator>
+#include <vector>
+#include <osmium/osm/way.hpp>
+
+#include "geo.hpp"
+#include "profile.hpp"
+#include "road_graph.hpp"
+#include "way_tags.hpp"
+
+// How a way contributes edges to the graph of a profile
+enum class WayDirection { none, both, forward, backward };
+
+WayDirection roadDirection(const WayAttributes& way, Profile profile);
+WayDirection roadDirection(const osmium::Way& way, Profile profile);
+
+// Expected speed in km/h. For cars a numeric maxspeed tag if there is one,
+// otherwise a default for the highway class; bikes and pedestrians use
+// fixed speeds per way type.
+double roadSpeedKmh(const WayAttributes& way, Profile profile);
+
+// Appends the edges of one way for the given profile. location_of(node_ref)
+// returns the node's osmium::Location, or an invalid one if it is unknown.
+// attributes is classifyWay(way.tags()), shared by all profiles of a way.
+template <typename TLocationOf>
+void emitWayEdges(const osmium::Way& way, const WayAttributes& attributes, Profile profile,
+                  TLocationOf&& location_of, std::vector<OsmEdge>& edges) {
+    WayDirection dir = roadDirection(attributes, profile);
+    if (dir == WayDirection::none) return;
+
+    const osmium::WayNodeList& wnl = way.nodes();
+    if (wnl.size() < 2) return;
+
+    const int64_t way_id = way.id();
+    const double speed = roadSpeedKmh(attributes, profile);
+    osmium::Location l1 = location_of(*wnl.begin());
+    // add edges according to the directionality indicated by tags
+    for (auto it = wnl.begin(); std::next(it) != wnl.end(); ++it) {
+        const osmium::Location l2 = location_of(*std::next(it));
+        if (l1.valid() && l2.valid()) { // skip if coordinates unknown
+            int64_t id1 = it->ref();
+            int64_t id2 = std::next(it)->ref();
+            double d = haversine(l1.lat(), l1.lon(), l2.lat(), l2.lon());
+            const uint32_t length = lengthUnits(d);
+            const uint32_t time = timeUnits(d, speed);
+
+            if (dir == WayDirection::backward) {
+                // edge only from id2 -> id1
+                edges.push_back({id2, id1, length, time, way_id});
+            } else if (dir == WayDirection::forward) {
+                // edge only from id1 -> id2 (way node order)
+                edges.push_back({id1, id2, length, time, way_id});
+            } else {
+                // bidirectional (normal two-way street)
+                edges.push_back({id1, id2, length, time, way_id});
+                edges.push_back({id2, id1, length, time, way_id});
+            }
+        }
+        l1 = l2;
+    }
+}
+
+template <typename TLocationOf>
+void emitWayEdges(const osmium::Way& way, Profile profile, TLocationOf&& location_of, std::vector<OsmEdge>& edges) {
+    emitWayEdges(way, classifyWay(way.tags()), profile, location_of, edges);
+}
+
+#endif
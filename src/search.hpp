@@ -0,0 +1,388 @@
+#ifndef SEARCH
+#define SEARCH
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include "geo.hpp"
+#include "road_graph.hpp"
+#include "search_queues.hpp"
+
+// Counters filled in by a search, for benchmarks
+struct SearchStats {
+    uint32_t settled = 0; // nodes taken from the queue and expanded
+};
+
+// Per-state search data kept from one query to the next, so a query costs
+// what it visits instead of an allocation and a fill per node. A state's
+// entry counts only if its stamp equals the current generation; begin()
+// bumps the generation, which forgets every state at once.
+class SearchWorkspace {
+public:
+    static constexpr uint32_t inf = std::numeric_limits<uint32_t>::max();
+
+    // Starts a query over states 0 .. num_states - 1, all unvisited
+    void begin(uint32_t num_states) {
+        if (m_entries.size() < num_states) m_entries.resize(num_states);
+        if (++m_generation == 0) {
+            // the stamps wrapped; clear them so no old entry matches
+            for (Entry& entry : m_entries) entry.stamp = 0;
+            m_generation = 1;
+        }
+    }
+
+    uint32_t gScore(uint32_t v) const { return current(v) ? m_entries[v].g : inf; }
+    uint32_t fScore(uint32_t v) const { return current(v) ? m_entries[v].f : inf; }
+    uint32_t parent(uint32_t v) const { return current(v) ? m_entries[v].parent : NodeIdMap::invalid_index; }
+
+    void set(uint32_t v, uint32_t g, uint32_t f, uint32_t parent) {
+        m_entries[v] = {m_generation, g, f, parent};
+    }
+
+private:
+    // one cache line holds all a search touches for four states
+    struct Entry {
+        uint32_t stamp = 0;
+        uint32_t g, f, parent;
+    };
+
+    bool current(uint32_t v) const { return m_entries[v].stamp == m_generation; }
+
+    std::vector<Entry> m_entries;
+    uint32_t m_generation = 0;
+};
+
+// The calling thread's instance of T, such as its SearchWorkspace or open
+// set, grown to the largest graph it has searched
+template <typename T>
+T& threadInstance() {
+    static thread_local T instance;
+    return instance;
+}
+
+// heuristic(v) result for a node known to have no path to the goal; the
+// search never queues it
+constexpr uint32_t no_path_bound = UINT32_MAX;
+
+// A* from start to goal under the given metric, guided by heuristic(v), a
+// consistent lower bound on the cost from v to goal, or no_path_bound. Works
+// on any graph type with numNodes() and forEachOutEdge(v, metric, f(to,
+// weight)); Queue is the open set (see search_queues.hpp).
+// Returns the node sequence, or an empty vector if goal is unreachable.
+template <typename Queue = DefaultSearchQueue, typename Graph, typename Heuristic>
+std::vector<uint32_t> astarWithBound(const Graph& g, uint32_t start, uint32_t goal, Metric metric,
+                                     Heuristic&& heuristic, SearchStats* stats = nullptr) {
+    SearchWorkspace& ws = threadInstance<SearchWorkspace>();
+    ws.begin(g.numNodes());
+    Queue& open = threadInstance<Queue>();
+    open.reset(g.numNodes());
+
+    const uint32_t start_bound = heuristic(start);
+    if (start_bound != no_path_bound) {
+        ws.set(start, 0, start_bound, NodeIdMap::invalid_index);
+        open.push(start, start_bound);
+    }
+
+    uint32_t nodes_explored = 0;
+
+    while (!open.empty()) {
+        const auto [current, current_fscore_in_queue] = open.pop();
+
+        if (Queue::may_pop_stale && current_fscore_in_queue > ws.fScore(current)) {
+            continue; // stale entry
+        }
+
+        nodes_explored++;
+
+        if (current == goal) {
+            std::vector<uint32_t> path;
+            for (uint32_t at = goal; at != NodeIdMap::invalid_index; at = ws.parent(at)) {
+                path.push_back(at);
+            }
+            std::reverse(path.begin(), path.end());
+            std::cout << "Path found! Nodes explored: " << nodes_explored << "\n";
+            if (stats) stats->settled = nodes_explored;
+            return path;
+        }
+
+        const uint32_t current_gscore = ws.gScore(current);
+        g.forEachOutEdge(current, metric, [&](uint32_t to, uint32_t weight) {
+            uint32_t tentative_gScore = current_gscore + weight;
+
+            if (tentative_gScore < ws.gScore(to)) {
+                const uint32_t bound = heuristic(to);
+                if (bound == no_path_bound) return;
+                const uint32_t f = tentative_gScore + bound;
+                ws.set(to, tentative_gScore, f, current);
+                open.push(to, f);
+            }
+        });
+    }
+
+    std::cout << "No path found after exploring " << nodes_explored << " nodes.\n";
+    if (stats) stats->settled = nodes_explored;
+    return {};
+}
+
+// A* with the straight-line lower bound (costLowerBound) as heuristic, on any
+// graph that also has coord(v)
+template <typename Queue = DefaultSearchQueue, typename Graph>
+std::vector<uint32_t> astar(const Graph& g, uint32_t start, uint32_t goal, Metric metric = Metric::distance,
+                            SearchStats* stats = nullptr) {
+    const Node goalNode = g.coord(goal);
+    auto heuristic = [&g, &goalNode, metric](uint32_t v) {
+        const Node c = g.coord(v);
+        return costLowerBound(metric, haversine(c.lat, c.lon, goalNode.lat, goalNode.lon));
+    };
+    return astarWithBound<Queue>(g, start, goal, metric, heuristic, stats);
+}
+
+// ALT heuristic towards one goal: the best landmark bound of g.landmarks
+// (see landmarkBound()). A bound of cap or more only comes out for a node
+// that cannot reach a landmark the goal reaches, so it cannot reach the goal
+// either and is reported as no_path_bound.
+class LandmarkBound {
+public:
+    static constexpr uint32_t cap = uint32_t(1) << 30;
+
+    LandmarkBound(const RoadGraph& g, uint32_t goal, Metric metric)
+        : m_from(g.landmarks.from(metric).data()), m_to(g.landmarks.to(metric).data()), m_stride(g.landmarks.stride) {
+        m_from_goal.fill(0);
+        m_to_goal.fill(0);
+        for (uint32_t i = 0; i < m_stride; ++i) {
+            const uint32_t from = m_from[std::size_t(goal) * m_stride + i];
+            m_from_goal[i] = from == landmark_unreachable ? 0 : from;
+            m_to_goal[i] = m_to[std::size_t(goal) * m_stride + i];
+        }
+    }
+
+    uint32_t operator()(uint32_t v) const {
+        const std::size_t row = std::size_t(v) * m_stride;
+        const uint32_t bound = landmarkBound(m_from + row, m_to + row, m_from_goal.data(), m_to_goal.data(), m_stride);
+        return bound < cap ? bound : no_path_bound;
+    }
+
+private:
+    const uint32_t* m_from;
+    const uint32_t* m_to;
+    uint32_t m_stride;
+    std::array<uint32_t, max_landmarks> m_from_goal;
+    std::array<uint32_t, max_landmarks> m_to_goal;
+};
+
+// A* with the ALT heuristic; g.landmarks must not be empty. Settles far fewer
+// nodes than astar() where roads have to detour around water or other
+// obstacles the straight line crosses.
+template <typename Queue = DefaultSearchQueue>
+std::vector<uint32_t> altAstar(const RoadGraph& g, uint32_t start, uint32_t goal, Metric metric = Metric::distance,
+                               SearchStats* stats = nullptr) {
+    return astarWithBound<Queue>(g, start, goal, metric, LandmarkBound(g, goal, metric), stats);
+}
+
+// A* that obeys the turn table of base, searched on g, which is base itself
+// or a GraphOverlay on top of it (anything with forEachOutEdgeIndexed()
+// giving base edge indices). Search states are nodes, except at via nodes of
+// turn restrictions, where arriving over each in-edge is a state of its own
+// so the forbidden out-edges can be skipped. That adds turns.numInEdges()
+// states instead of expanding every edge. Edges an overlay added are not in
+// the table; GraphOverlay::changesTurns() says when that matters. The
+// returned node sequence may pass a via node twice when the legal route loops
+// around a block.
+template <typename Queue = DefaultSearchQueue, typename Graph>
+std::vector<uint32_t> astarWithTurns(const Graph& g, const RoadGraph& base, uint32_t start, uint32_t goal,
+                                     Metric metric = Metric::distance, SearchStats* stats = nullptr) {
+    const uint32_t n = g.numNodes();
+    const TurnTable& turns = base.turns;
+    SearchWorkspace& ws = threadInstance<SearchWorkspace>();
+    ws.begin(n + turns.numInEdges());
+    Queue& open = threadInstance<Queue>();
+    open.reset(n + turns.numInEdges());
+
+    // state n + i is "at the head of turns.in_edges[i], arrived over it"
+    auto nodeOf = [&](uint32_t state) { return state < n ? state : base.head[turns.in_edges[state - n]]; };
+
+    const Node goalNode = g.coord(goal);
+    auto heuristic = [&g, &goalNode, metric](uint32_t v) {
+        const Node c = g.coord(v);
+        return costLowerBound(metric, haversine(c.lat, c.lon, goalNode.lat, goalNode.lon));
+    };
+
+    const uint32_t start_bound = heuristic(start);
+    if (start_bound != no_path_bound) {
+        ws.set(start, 0, start_bound, NodeIdMap::invalid_index);
+        open.push(start, start_bound);
+    }
+
+    uint32_t nodes_explored = 0;
+    while (!open.empty()) {
+        const auto [current, current_fscore_in_queue] = open.pop();
+        if (Queue::may_pop_stale && current_fscore_in_queue > ws.fScore(current)) {
+            continue; // stale entry
+        }
+        nodes_explored++;
+
+        const uint32_t v = nodeOf(current);
+        if (v == goal) {
+            std::vector<uint32_t> path;
+            for (uint32_t at = current; at != NodeIdMap::invalid_index; at = ws.parent(at)) {
+                path.push_back(nodeOf(at));
+            }
+            std::reverse(path.begin(), path.end());
+            std::cout << "Path found! Nodes explored: " << nodes_explored << "\n";
+            if (stats) stats->settled = nodes_explored;
+            return path;
+        }
+
+        // only via states, which are base nodes, look at out-edge ranks
+        const bool at_via = current >= n;
+        const uint32_t out_begin = at_via ? base.first_out[v] : 0;
+        const uint32_t out_degree = at_via ? base.first_out[v + 1] - out_begin : 0;
+        const uint32_t slot = at_via ? turns.viaSlot(v) : 0;
+        const uint32_t current_gscore = ws.gScore(current);
+        g.forEachOutEdgeIndexed(v, metric, [&](uint32_t e, uint32_t to, uint32_t weight) {
+            const bool in_table = e != NodeIdMap::invalid_index;
+            if (at_via && in_table && turns.forbiddenTurn(slot, current - n, e - out_begin, out_degree)) return;
+            const uint32_t next = in_table && turns.isVia(to) ? n + turns.inEdgeIndex(turns.viaSlot(to), e) : to;
+            const uint32_t tentative_gScore = current_gscore + weight;
+            if (tentative_gScore < ws.gScore(next)) {
+                const uint32_t f = tentative_gScore + heuristic(to);
+                ws.set(next, tentative_gScore, f, current);
+                open.push(next, f);
+            }
+        });
+    }
+
+    std::cout << "No path found after exploring " << nodes_explored << " nodes.\n";
+    if (stats) stats->settled = nodes_explored;
+    return {};
+}
+
+// A* that obeys g.turns, on g itself
+template <typename Queue = DefaultSearchQueue>
+std::vector<uint32_t> astarWithTurns(const RoadGraph& g, uint32_t start, uint32_t goal,
+                                     Metric metric = Metric::distance, SearchStats* stats = nullptr) {
+    return astarWithTurns<Queue>(g, g, start, goal, metric, stats);
+}
+
+// Bidirectional A* over g, which needs g.reverse (see reverse_adjacency.hpp).
+// One search runs forward from start, the other backward from goal over the
+// in-edges, and each step advances the side whose last key is lower. Both use
+// the average of the two straight-line bounds as potential,
+//   p(v) = (h_goal(v) - h_start(v)) / 2 forward and -p(v) backward,
+// which keeps reduced edge costs non-negative for both sides at once. Keys
+// are doubled to stay integers and offset by h(start, goal) + 2, so they are
+// never negative. Whenever an edge links the two searches, the cost of the
+// best route over it is recorded as mu; once the last keys of the two sides
+// add up to 2 mu (plus the offsets) no shorter route can remain. The path is
+// joined at the node where the best route was found.
+template <typename Queue = DefaultSearchQueue>
+std::vector<uint32_t> bidirectionalAstar(const RoadGraph& g, uint32_t start, uint32_t goal,
+                                         Metric metric = Metric::distance, SearchStats* stats = nullptr) {
+    if (start == goal) {
+        if (stats) stats->settled = 0;
+        return {start};
+    }
+    const uint32_t n = g.numNodes();
+    const GraphArray<uint32_t>& weight = g.weights(metric);
+    const ReverseAdjacency& reverse = g.reverse;
+
+    struct Workspaces {
+        SearchWorkspace forward, backward;
+    };
+    struct Queues {
+        Queue forward, backward;
+    };
+    Workspaces& ws = threadInstance<Workspaces>();
+    Queues& open = threadInstance<Queues>();
+    ws.forward.begin(n);
+    ws.backward.begin(n);
+    open.forward.reset(n);
+    open.backward.reset(n);
+
+    const Node start_node = g.coord(start);
+    const Node goal_node = g.coord(goal);
+    auto bound = [metric](const Node& a, const Node& b) {
+        return int64_t(costLowerBound(metric, haversine(a.lat, a.lon, b.lat, b.lon)));
+    };
+    const int64_t offset = bound(start_node, goal_node) + 2;
+    // doubled forward key of v reached at cost gv; the backward key mirrors it
+    auto key = [&](uint32_t v, uint32_t gv, bool forward) {
+        const Node c = g.coord(v);
+        const int64_t to_goal = bound(c, goal_node), from_start = bound(c, start_node);
+        const int64_t k = 2 * int64_t(gv) + (forward ? to_goal - from_start : from_start - to_goal) + offset;
+        return static_cast<uint32_t>(std::max<int64_t>(k, 0));
+    };
+
+    ws.forward.set(start, 0, key(start, 0, true), NodeIdMap::invalid_index);
+    ws.backward.set(goal, 0, key(goal, 0, false), NodeIdMap::invalid_index);
+    open.forward.push(start, ws.forward.fScore(start));
+    open.backward.push(goal, ws.backward.fScore(goal));
+    uint64_t last_forward = ws.forward.fScore(start), last_backward = ws.backward.fScore(goal);
+
+    uint64_t mu = std::numeric_limits<uint64_t>::max();
+    uint32_t meeting = NodeIdMap::invalid_index;
+    uint32_t nodes_explored = 0;
+    while (!open.forward.empty() && !open.backward.empty()) {
+        const bool forward = last_forward <= last_backward;
+        SearchWorkspace& own = forward ? ws.forward : ws.backward;
+        const SearchWorkspace& other = forward ? ws.backward : ws.forward;
+        const auto [current, current_key] = forward ? open.forward.pop() : open.backward.pop();
+        (forward ? last_forward : last_backward) = current_key;
+        if (mu != std::numeric_limits<uint64_t>::max() &&
+            last_forward + last_backward >= 2 * mu + 2 * uint64_t(offset)) {
+            break;
+        }
+        if (Queue::may_pop_stale && current_key > own.fScore(current)) {
+            continue; // stale entry
+        }
+        nodes_explored++;
+
+        const uint32_t current_gscore = own.gScore(current);
+        auto relax = [&](uint32_t to, uint32_t w) {
+            const uint32_t tentative_gScore = current_gscore + w;
+            const uint32_t other_gscore = other.gScore(to);
+            if (other_gscore != SearchWorkspace::inf && uint64_t(tentative_gScore) + other_gscore < mu) {
+                mu = uint64_t(tentative_gScore) + other_gscore;
+                meeting = to;
+            }
+            if (tentative_gScore < own.gScore(to)) {
+                const uint32_t k = key(to, tentative_gScore, forward);
+                own.set(to, tentative_gScore, k, current);
+                (forward ? open.forward : open.backward).push(to, k);
+            }
+        };
+        if (forward) {
+            for (uint32_t e = g.first_out[current]; e < g.first_out[current + 1]; ++e) {
+                relax(g.head[e], weight[e]);
+            }
+        } else {
+            for (uint32_t i = reverse.first_in[current]; i < reverse.first_in[current + 1]; ++i) {
+                relax(reverse.tail[i], weight[reverse.in_edge[i]]);
+            }
+        }
+    }
+
+    if (stats) stats->settled = nodes_explored;
+    if (meeting == NodeIdMap::invalid_index) {
+        std::cout << "No path found after exploring " << nodes_explored << " nodes.\n";
+        return {};
+    }
+    // start .. meeting from the forward parents, then on to goal from the backward ones
+    std::vector<uint32_t> path;
+    for (uint32_t at = meeting; at != NodeIdMap::invalid_index; at = ws.forward.parent(at)) {
+        path.push_back(at);
+    }
+    std::reverse(path.begin(), path.end());
+    for (uint32_t at = ws.backward.parent(meeting); at != NodeIdMap::invalid_index; at = ws.backward.parent(at)) {
+        path.push_back(at);
+    }
+    std::cout << "Path found! Nodes explored: " << nodes_explored << "\n";
+    return path;
+}
+
+#endif
@@ -0,0 +1,274 @@
+#ifndef SEARCH_QUEUES
+#define SEARCH_QUEUES
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// Open sets for astar() and astarWithTurns(), picked by template argument.
+// Each one holds (state, key) pairs and offers
+//   reset(num_states)  empty it for a query over states 0 .. num_states - 1
+//   empty()
+//   push(state, key)   add the state, or lower its key if it is queued
+//   pop()              remove and return the (state, key) with the least key
+// may_pop_stale says whether pop() can return a state whose key has since
+// been lowered, which the search must then skip.
+
+// Indexed d-ary min-heap with decrease-key. A position array finds a queued
+// state's slot, so each state is in the heap at most once and the heap never
+// grows past the frontier. A wider node makes the heap shallower and keeps
+// siblings in one cache line, at the price of more comparisons per level.
+template <unsigned D = 4>
+class IndexedDaryHeap {
+public:
+    static_assert(D >= 2, "a heap node needs at least two children");
+    static constexpr bool may_pop_stale = false;
+
+    void reset(uint32_t num_states) {
+        // a search that stopped early leaves states queued
+        for (const Item& item : m_heap) m_pos[item.state] = not_queued;
+        m_heap.clear();
+        if (m_pos.size() < num_states) m_pos.resize(num_states, not_queued);
+    }
+
+    bool empty() const { return m_heap.empty(); }
+
+    void push(uint32_t state, uint32_t key) {
+        uint32_t i = m_pos[state];
+        if (i == not_queued) {
+            i = static_cast<uint32_t>(m_heap.size());
+            m_heap.push_back({key, state});
+        } else if (key < m_heap[i].key) {
+            m_heap[i].key = key;
+        } else {
+            return;
+        }
+        siftUp(i);
+    }
+
+    std::pair<uint32_t, uint32_t> pop() {
+        const Item top = m_heap.front();
+        m_pos[top.state] = not_queued;
+        const Item last = m_heap.back();
+        m_heap.pop_back();
+        if (!m_heap.empty()) siftDown(last);
+        return {top.state, top.key};
+    }
+
+private:
+    static constexpr uint32_t not_queued = 0xffffffff;
+
+    struct Item {
+        uint32_t key;
+        uint32_t state;
+    };
+
+    void place(uint32_t i, const Item& item) {
+        m_heap[i] = item;
+        m_pos[item.state] = i;
+    }
+
+    void siftUp(uint32_t i) {
+        const Item item = m_heap[i];
+        while (i > 0) {
+            const uint32_t parent = (i - 1) / D;
+            if (m_heap[parent].key <= item.key) break;
+            place(i, m_heap[parent]);
+            i = parent;
+        }
+        place(i, item);
+    }
+
+    // moves item down from the root into the hole pop() left
+    void siftDown(const Item& item) {
+        const std::size_t n = m_heap.size();
+        uint32_t i = 0;
+        while (true) {
+            const std::size_t first = std::size_t(i) * D + 1;
+            if (first >= n) break;
+            std::size_t best = first;
+            const std::size_t last = std::min(first + D, n);
+            for (std::size_t c = first + 1; c < last; ++c) {
+                if (m_heap[c].key < m_heap[best].key) best = c;
+            }
+            if (m_heap[best].key >= item.key) break;
+            place(i, m_heap[best]);
+            i = static_cast<uint32_t>(best);
+        }
+        place(i, item);
+    }
+
+    std::vector<Item> m_heap;
+    std::vector<uint32_t> m_pos; // slot in m_heap per state, not_queued if absent
+};
+
+// std::push_heap/pop_heap binary heap with lazy deletion: lowering a key
+// pushes a second entry and the old one is skipped when it comes up. The
+// search's behaviour before IndexedDaryHeap, kept for comparison.
+class LazyBinaryHeap {
+public:
+    static constexpr bool may_pop_stale = true;
+
+    void reset(uint32_t) { m_heap.clear(); }
+
+    bool empty() const { return m_heap.empty(); }
+
+    void push(uint32_t state, uint32_t key) {
+        m_heap.push_back({state, key});
+        std::push_heap(m_heap.begin(), m_heap.end(), laterFirst);
+    }
+
+    std::pair<uint32_t, uint32_t> pop() {
+        std::pop_heap(m_heap.begin(), m_heap.end(), laterFirst);
+        const std::pair<uint32_t, uint32_t> top = m_heap.back();
+        m_heap.pop_back();
+        return top;
+    }
+
+private:
+    static bool laterFirst(const std::pair<uint32_t, uint32_t>& a, const std::pair<uint32_t, uint32_t>& b) {
+        return a.second > b.second;
+    }
+
+    std::vector<std::pair<uint32_t, uint32_t>> m_heap;
+};
+
+// The two queues below need integer keys that never fall below the last key
+// popped, which holds for Dijkstra and for A* with a consistent heuristic
+// such as costLowerBound. A key that is lower anyway (rounding) is queued as
+// if it were equal to the last key popped, so the search stays correct and
+// at worst expands a state once more.
+
+// Monotone radix heap. Bucket 0 holds the keys equal to the last key popped,
+// bucket i those whose highest bit differing from it is bit i - 1. When bucket
+// 0 runs empty, the first non-empty bucket is split into lower ones around its
+// least key, so each entry moves at most 32 times over a query. Lazy like
+// LazyBinaryHeap.
+class RadixHeap {
+public:
+    static constexpr bool may_pop_stale = true;
+
+    void reset(uint32_t) {
+        for (auto& bucket : m_buckets) bucket.clear();
+        m_last = 0;
+        m_size = 0;
+    }
+
+    bool empty() const { return m_size == 0; }
+
+    void push(uint32_t state, uint32_t key) {
+        m_buckets[bucketOf(key)].push_back({state, key});
+        ++m_size;
+    }
+
+    std::pair<uint32_t, uint32_t> pop() {
+        if (m_buckets[0].empty()) {
+            std::size_t i = 1;
+            while (m_buckets[i].empty()) ++i;
+            uint32_t least = m_buckets[i][0].second;
+            for (const auto& item : m_buckets[i]) least = std::min(least, item.second);
+            m_last = std::max(least, m_last);
+            for (const auto& item : m_buckets[i]) m_buckets[bucketOf(item.second)].push_back(item);
+            m_buckets[i].clear();
+        }
+        const std::pair<uint32_t, uint32_t> top = m_buckets[0].back();
+        m_buckets[0].pop_back();
+        --m_size;
+        return top;
+    }
+
+private:
+    std::size_t bucketOf(uint32_t key) const {
+        uint32_t diff = std::max(key, m_last) ^ m_last;
+        std::size_t bucket = 0;
+        while (diff != 0) {
+            diff >>= 1;
+            ++bucket;
+        }
+        return bucket;
+    }
+
+    std::array<std::vector<std::pair<uint32_t, uint32_t>>, 33> m_buckets;
+    uint32_t m_last = 0;
+    std::size_t m_size = 0;
+};
+
+// Dial's bucket queue: one bucket per key value in a ring that covers the
+// keys from the last one popped, or the lowest queued before the first pop,
+// up to the largest queued. pop() walks the ring to the next non-empty
+// bucket, so it suits searches whose keys grow in small steps. The ring
+// doubles when a key lies beyond it. Lazy like LazyBinaryHeap.
+class DialQueue {
+public:
+    static constexpr bool may_pop_stale = true;
+
+    void reset(uint32_t) {
+        for (std::size_t b : m_used) m_buckets[b].clear();
+        m_used.clear();
+        m_current = 0;
+        m_popped = false;
+        m_size = 0;
+        if (m_buckets.empty()) m_buckets.resize(1024);
+    }
+
+    bool empty() const { return m_size == 0; }
+
+    void push(uint32_t state, uint32_t key) {
+        if (!m_popped && (m_size == 0 || key < m_current)) {
+            // until the first pop the ring starts at the lowest key queued,
+            // not at 0, so it only spans the keys of this query
+            const uint64_t span = m_size == 0 ? 0 : uint64_t(m_current) + m_buckets.size() - key;
+            m_current = key;
+            if (span > m_buckets.size()) grow(span);
+        }
+        const uint64_t slot = std::max(key, m_current);
+        if (slot - m_current >= m_buckets.size()) grow(slot - m_current + 1);
+        auto& bucket = m_buckets[slot & (m_buckets.size() - 1)];
+        if (bucket.empty()) m_used.push_back(slot & (m_buckets.size() - 1));
+        bucket.push_back({state, key});
+        ++m_size;
+    }
+
+    std::pair<uint32_t, uint32_t> pop() {
+        const std::size_t mask = m_buckets.size() - 1;
+        while (m_buckets[m_current & mask].empty()) ++m_current;
+        auto& bucket = m_buckets[m_current & mask];
+        const std::pair<uint32_t, uint32_t> top = bucket.back();
+        m_popped = true;
+        bucket.pop_back();
+        --m_size;
+        return top;
+    }
+
+private:
+    // re-files the queued entries into a ring of at least span buckets
+    void grow(uint64_t span) {
+        std::size_t size = m_buckets.size();
+        while (size < span) size *= 2;
+        std::vector<std::vector<std::pair<uint32_t, uint32_t>>> buckets(size);
+        std::vector<std::size_t> used;
+        for (const auto& bucket : m_buckets) {
+            for (const auto& item : bucket) {
+                const std::size_t slot = std::max(item.second, m_current) & (size - 1);
+                if (buckets[slot].empty()) used.push_back(slot);
+                buckets[slot].push_back(item);
+            }
+        }
+        m_buckets.swap(buckets);
+        m_used.swap(used);
+    }
+
+    std::vector<std::vector<std::pair<uint32_t, uint32_t>>> m_buckets; // size a power of two
+    std::vector<std::size_t> m_used; // buckets filled this query, for reset(); may repeat
+    uint32_t m_current = 0;          // key of the bucket pop() looks at first
+    bool m_popped = false;           // since reset(); until then m_current is the lowest key queued
+    std::size_t m_size = 0;
+};
+
+// Open set the searches use unless told otherwise
+using DefaultSearchQueue = IndexedDaryHeap<4>;
+
+#endif
@@ -0,0 +1,140 @@
+#include "spatial_index.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include "geo.hpp"
+#include "road_graph.hpp"
+
+double minMetersPerDegree(const GridParams& p) {
+    double max_abs_lat = std::max(std::fabs(p.min_lat), std::fabs(p.min_lat + p.rows * p.cell_deg));
+    max_abs_lat = std::min(max_abs_lat, 89.0);
+    return std::min(110574.0, 111320.0 * std::cos(deg2rad(max_abs_lat)));
+}
+
+std::vector<bool> nodesWithEdges(const RoadGraph& g) {
+    std::vector<bool> used(g.numNodes(), false);
+    for (uint32_t v = 0; v < g.numNodes(); ++v) {
+        if (g.first_out[v] != g.first_out[v + 1]) used[v] = true;
+    }
+    for (uint32_t to : g.head) {
+        used[to] = true;
+    }
+    return used;
+}
+
+SpatialGrid buildSpatialGrid(const RoadGraph& g, double cell_deg) {
+    SpatialGrid grid;
+    const NodeCoords& coords = g.coords;
+    const std::vector<bool> used = nodesWithEdges(g);
+    uint32_t count = 0;
+    double min_lat = 0, max_lat = 0, min_lon = 0, max_lon = 0;
+    for (uint32_t v = 0; v < coords.size(); ++v) {
+        if (!used[v]) continue;
+        const Node n = coords[v];
+        if (count++ == 0) {
+            min_lat = max_lat = n.lat;
+            min_lon = max_lon = n.lon;
+        }
+        min_lat = std::min(min_lat, n.lat);
+        max_lat = std::max(max_lat, n.lat);
+        min_lon = std::min(min_lon, n.lon);
+        max_lon = std::max(max_lon, n.lon);
+    }
+    if (count == 0 || cell_deg <= 0) return grid;
+
+    GridParams p;
+    p.min_lat = min_lat;
+    p.min_lon = min_lon;
+    p.cell_deg = cell_deg;
+    p.rows = static_cast<uint32_t>((max_lat - min_lat) / cell_deg) + 1;
+    p.cols = static_cast<uint32_t>((max_lon - min_lon) / cell_deg) + 1;
+
+    auto cellOf = [&p](const Node& n) {
+        uint32_t row = std::min(p.rows - 1, static_cast<uint32_t>((n.lat - p.min_lat) / p.cell_deg));
+        uint32_t col = std::min(p.cols - 1, static_cast<uint32_t>((n.lon - p.min_lon) / p.cell_deg));
+        return row * p.cols + col;
+    };
+
+    // counting sort of the nodes by cell
+    const std::size_t cells = static_cast<std::size_t>(p.rows) * p.cols;
+    std::vector<uint32_t> first(cells + 1, 0);
+    for (uint32_t v = 0; v < coords.size(); ++v) {
+        if (used[v]) first[cellOf(coords[v]) + 1]++;
+    }
+    for (std::size_t c = 0; c < cells; ++c) {
+        first[c + 1] += first[c];
+    }
+    std::vector<uint32_t> nodes(count);
+    std::vector<uint32_t> next(first.begin(), first.end() - 1);
+    for (uint32_t v = 0; v < coords.size(); ++v) {
+        if (used[v]) nodes[next[cellOf(coords[v])]++] = v;
+    }
+
+    grid.params = p;
+    grid.first = std::move(first);
+    grid.nodes = std::move(nodes);
+    return grid;
+}
+
+// Ring search over the grid arrays in memory
+template <typename Accept>
+static uint32_t gridSearch(const SpatialGrid& grid, const NodeCoords& coords, double lat, double lon,
+                           double max_dist, Accept&& accept) {
+    if (grid.empty()) return std::numeric_limits<uint32_t>::max();
+    auto cellNodes = [&grid](std::size_t c, auto&& visit) {
+        for (uint32_t i = grid.first[c]; i < grid.first[c + 1]; ++i) {
+            visit(grid.nodes[i]);
+        }
+    };
+    return ringSearch(grid.params, cellNodes, [&coords](uint32_t v) { return coords[v]; },
+                      lat, lon, max_dist, accept);
+}
+
+uint32_t nearestNode(const SpatialGrid& grid, const NodeCoords& coords, double lat, double lon) {
+    return gridSearch(grid, coords, lat, lon, std::numeric_limits<double>::infinity(), [](uint32_t) { return true; });
+}
+
+// linear search over the nodes with edges (slow for full map, but fine for testing)
+template <typename Accept>
+static uint32_t linearSearch(const RoadGraph& g, const std::vector<bool>& used, double lat, double lon,
+                             double max_dist, Accept&& accept) {
+    double bestDist = max_dist;
+    uint32_t best = std::numeric_limits<uint32_t>::max();
+    for (uint32_t v = 0; v < g.numNodes(); ++v) {
+        if (!used[v]) continue;
+        const Node c = g.coords[v];
+        double d = haversine(lat, lon, c.lat, c.lon);
+        if (d < bestDist && accept(v)) {
+            bestDist = d;
+            best = v;
+        }
+    }
+    return best;
+}
+
+// Helper: find nearest node index for a lat/lon. Uses the spatial grid when the
+// graph has one, otherwise a linear search. A node of the giant component is
+// preferred over a closer one in a small component (a parking aisle, a one-way
+// island) unless it is more than giant_snap_slack_m farther away, since routes
+// from the small component mostly fail or detour.
+uint32_t findNearestNode(const RoadGraph& g, double lat, double lon) {
+    const double inf = std::numeric_limits<double>::infinity();
+    std::vector<bool> used;
+    auto search = [&](double max_dist, auto&& accept) {
+        if (!g.grid.empty()) return gridSearch(g.grid, g.coords, lat, lon, max_dist, accept);
+        if (used.empty()) used = nodesWithEdges(g);
+        return linearSearch(g, used, lat, lon, max_dist, accept);
+    };
+
+    uint32_t best = search(inf, [](uint32_t) { return true; });
+    if (best == std::numeric_limits<uint32_t>::max()) return 0;
+    if (g.component.empty() || g.component[best] == 0) return best;
+
+    const Node c = g.coords[best];
+    const double best_dist = haversine(lat, lon, c.lat, c.lon);
+    uint32_t giant = search(best_dist + giant_snap_slack_m, [&g](uint32_t v) { return g.component[v] == 0; });
+    return giant != std::numeric_limits<uint32_t>::max() ? giant : best;
+}
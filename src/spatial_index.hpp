@@ -0,0 +1,106 @@
+#ifndef SPATIAL_INDEX
+#define SPATIAL_INDEX
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "geo.hpp"
+#include "graph_array.hpp"
+#include "node_coords.hpp"
+
+struct RoadGraph;
+
+struct GridParams {
+    double min_lat, min_lon;
+    double cell_deg;     // cell edge length in degrees
+    uint32_t rows, cols; // rows along latitude, cols along longitude
+};
+
+// Uniform lat/lon grid over the graph nodes, stored CSR-style: the nodes in cell
+// c = row * cols + col are nodes[first[c]] .. nodes[first[c + 1] - 1].
+struct SpatialGrid {
+    GridParams params{};
+    GraphArray<uint32_t> first;
+    GraphArray<uint32_t> nodes;
+
+    bool empty() const { return first.empty(); }
+};
+
+// Indexes the nodes that have at least one edge; shape nodes removed by
+// contractChains() cannot be routed from or to
+SpatialGrid buildSpatialGrid(const RoadGraph& g, double cell_deg);
+
+// true for every node that is the source or target of an edge
+std::vector<bool> nodesWithEdges(const RoadGraph& g);
+
+// lower bound for the length of one degree, in meters, anywhere on the grid
+double minMetersPerDegree(const GridParams& p);
+
+// Ring search around the query cell for the nearest node accepted by the
+// filter, giving up beyond max_dist meters. cellNodes(c, visit) calls visit(v)
+// for every node in cell c = row * cols + col and coordOf(v) locates a node, so
+// the cells and coordinates may live outside memory (see TiledGraph).
+template <typename CellNodes, typename CoordOf, typename Accept>
+uint32_t ringSearch(const GridParams& p, CellNodes&& cellNodes, CoordOf&& coordOf, double lat, double lon,
+                    double max_dist, Accept&& accept) {
+    uint32_t best = std::numeric_limits<uint32_t>::max();
+    if (p.rows == 0 || p.cols == 0) return best;
+
+    // query cell, possibly outside the grid
+    const int64_t qrow = static_cast<int64_t>(std::floor((lat - p.min_lat) / p.cell_deg));
+    const int64_t qcol = static_cast<int64_t>(std::floor((lon - p.min_lon) / p.cell_deg));
+    const double ring_m = p.cell_deg * minMetersPerDegree(p);
+
+    // rings beyond this distance contain no grid cells
+    const int64_t max_ring = std::max({qrow, int64_t(p.rows) - 1 - qrow, qcol, int64_t(p.cols) - 1 - qcol,
+                                       -qrow, -qcol, qrow - int64_t(p.rows) + 1, qcol - int64_t(p.cols) + 1});
+
+    double best_dist = max_dist;
+    auto scanCell = [&](int64_t row, int64_t col) {
+        if (row < 0 || col < 0 || row >= p.rows || col >= p.cols) return;
+        std::size_t c = static_cast<std::size_t>(row) * p.cols + static_cast<std::size_t>(col);
+        cellNodes(c, [&](uint32_t v) {
+            const Node n = coordOf(v);
+            double d = haversine(lat, lon, n.lat, n.lon);
+            if (d < best_dist && accept(v)) {
+                best_dist = d;
+                best = v;
+            }
+        });
+    };
+
+    for (int64_t r = 0; r <= max_ring; ++r) {
+        // anything in ring r is at least (r - 1) cells away from the query point
+        if (r > 0 && best_dist <= (r - 1) * ring_m) break;
+        if (r == 0) {
+            scanCell(qrow, qcol);
+            continue;
+        }
+        for (int64_t col = qcol - r; col <= qcol + r; ++col) {
+            scanCell(qrow - r, col);
+            scanCell(qrow + r, col);
+        }
+        for (int64_t row = qrow - r + 1; row <= qrow + r - 1; ++row) {
+            scanCell(row, qcol - r);
+            scanCell(row, qcol + r);
+        }
+    }
+    return best;
+}
+
+// Nearest node to lat/lon by ring search around the query cell. Returns
+// UINT32_MAX if the grid has no nodes.
+uint32_t nearestNode(const SpatialGrid& grid, const NodeCoords& coords, double lat, double lon);
+
+// how much farther a node of the giant component may be than the nearest node
+// and still be preferred when snapping
+constexpr double giant_snap_slack_m = 250.0;
+
+// Nearest node of the graph, through its grid if it has one, preferring the
+// giant strongly connected component (see components.hpp)
+uint32_t findNearestNode(const RoadGraph& g, double lat, double lon);
+
+#endif
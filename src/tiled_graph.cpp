@@ -0,0 +1,349 @@
+#include "tiled_graph.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "components.hpp"
+#include "spatial_index.hpp"
+
+TiledGraph::TiledGraph(const std::string& filename, Profile profile, std::size_t memory_cap)
+    : m_filename(filename), m_profile(profile), m_layout(readSnapshotLayout(filename)), m_memory_cap(memory_cap) {
+    auto slot = std::find(m_layout.profiles.begin(), m_layout.profiles.end(), profile);
+    if (slot == m_layout.profiles.end()) {
+        throw std::runtime_error("snapshot has no " + std::string(profileName(profile)) + " graph: " + filename);
+    }
+    m_slot = static_cast<std::size_t>(slot - m_layout.profiles.begin());
+    if (!m_layout.find(m_slot, section_tile_params)) {
+        throw std::runtime_error("snapshot has no tile index, rebuild it with route_tracer_prep: " + filename);
+    }
+    if (!m_layout.find(m_slot, section_grid_params)) {
+        throw std::runtime_error("snapshot has no spatial index: " + filename);
+    }
+    m_fd = open(filename.c_str(), O_RDONLY);
+    if (m_fd < 0) {
+        throw std::runtime_error("cannot open snapshot file " + filename);
+    }
+
+    try {
+        // element sizes are checked by read()
+        m_num_nodes = static_cast<uint32_t>(section(section_lat).count);
+        m_num_edges = static_cast<uint32_t>(section(section_head).count);
+        m_has_turn_restrictions = m_layout.find(m_slot, section_turn_restrictions) != nullptr;
+
+        const SectionEntry& first_node = section(section_tile_first_node);
+        const SectionEntry& boundary_first = section(section_tile_boundary_first);
+        std::vector<uint32_t> tile_first(first_node.count), tile_boundary_first(boundary_first.count);
+        read(first_node, 0, tile_first.size(), tile_first.data());
+        read(boundary_first, 0, tile_boundary_first.size(), tile_boundary_first.data());
+        m_index.tile_bytes = readOne<uint64_t>(section(section_tile_params), 0);
+        m_index.first_node = std::move(tile_first);
+        m_index.boundary_first = std::move(tile_boundary_first);
+
+        m_grid_params = readOne<GridParams>(section(section_grid_params), 0);
+        const SectionEntry& grid_first = section(section_grid_first);
+        m_grid_first.resize(grid_first.count);
+        read(grid_first, 0, m_grid_first.size(), m_grid_first.data());
+
+        if (const SectionEntry* flags = m_layout.find(m_slot, section_component_flags)) {
+            m_component_flags.resize(flags->count);
+            read(*flags, 0, m_component_flags.size(), m_component_flags.data());
+        }
+
+        const uint32_t n = m_num_nodes;
+        const uint32_t tiles = m_index.numTiles();
+        if (section(section_lon).count != n || section(section_osm_ids).count != n ||
+            section(section_first_out).count != uint64_t(n) + 1 ||
+            section(section_length).count != m_num_edges || section(section_travel_time).count != m_num_edges ||
+            m_index.first_node.size() < 2 || m_index.first_node[tiles] != n ||
+            m_index.boundary_first.size() != m_index.first_node.size() ||
+            m_index.boundary_first[tiles] != section(section_tile_boundary_edges).count ||
+            m_grid_first.size() != std::size_t(m_grid_params.rows) * m_grid_params.cols + 1 ||
+            (!m_component_flags.empty() && section(section_component).count != n)) {
+            throw std::runtime_error("snapshot sections do not match: " + filename);
+        }
+        for (uint32_t t = 0; t < tiles; ++t) {
+            const uint32_t size = m_index.first_node[t + 1] - m_index.first_node[t];
+            if (size == 0 || size > max_tile_nodes) {
+                throw std::runtime_error("snapshot sections do not match: " + filename);
+            }
+        }
+        m_tiles.resize(tiles);
+    } catch (...) {
+        close(m_fd);
+        throw;
+    }
+}
+
+TiledGraph::~TiledGraph() {
+    close(m_fd);
+}
+
+const SectionEntry& TiledGraph::section(uint32_t id) const {
+    const SectionEntry* entry = m_layout.find(m_slot, id);
+    if (!entry) {
+        throw std::runtime_error("snapshot is missing section " + std::to_string(id));
+    }
+    return *entry;
+}
+
+template <typename T>
+void TiledGraph::read(const SectionEntry& entry, uint64_t first, std::size_t count, T* out) const {
+    if (entry.element_size != sizeof(T) || first > entry.count || count > entry.count - first) {
+        throw std::runtime_error("corrupt snapshot section " + std::to_string(entry.id));
+    }
+    char* data = reinterpret_cast<char*>(out);
+    std::size_t left = count * sizeof(T);
+    uint64_t offset = entry.offset + first * sizeof(T);
+    while (left > 0) {
+        const ssize_t got = pread(m_fd, data, left, static_cast<off_t>(offset));
+        if (got <= 0) {
+            throw std::runtime_error("cannot read snapshot file " + m_filename);
+        }
+        data += got;
+        left -= static_cast<std::size_t>(got);
+        offset += static_cast<uint64_t>(got);
+    }
+}
+
+template <typename T>
+T TiledGraph::readOne(const SectionEntry& entry, uint64_t index) const {
+    T value;
+    read(entry, index, 1, &value);
+    return value;
+}
+
+std::size_t TiledGraph::Tile::bytes() const {
+    return (first_out.capacity() + length.capacity() + travel_time.capacity() + boundary_first.capacity() +
+            boundary_head.capacity() + boundary_length.capacity() + boundary_time.capacity() +
+            component.capacity()) * sizeof(uint32_t) +
+           head.capacity() * sizeof(uint16_t) + (lat.capacity() + lon.capacity()) * sizeof(int32_t) +
+           osm_ids.capacity() * sizeof(int64_t) + sizeof(Tile);
+}
+
+// The edges of the tile's nodes are one range of the edge arrays. It is read
+// whole and split into inner and boundary edges by walking the tile's
+// boundary list alongside.
+std::unique_ptr<TiledGraph::Tile> TiledGraph::readTile(uint32_t t) const {
+    auto tile = std::make_unique<Tile>();
+    tile->index = t;
+    tile->first_node = m_index.first_node[t];
+    tile->num_nodes = m_index.first_node[t + 1] - tile->first_node;
+    const uint32_t n = tile->num_nodes;
+
+    std::vector<uint32_t> first_out(n + 1);
+    read(section(section_first_out), tile->first_node, n + 1, first_out.data());
+    const uint32_t first_edge = first_out[0];
+    const uint32_t edges = first_out[n] - first_edge;
+    std::vector<uint32_t> head(edges), length(edges), travel_time(edges);
+    read(section(section_head), first_edge, edges, head.data());
+    read(section(section_length), first_edge, edges, length.data());
+    read(section(section_travel_time), first_edge, edges, travel_time.data());
+    std::vector<uint32_t> boundary(m_index.boundary_first[t + 1] - m_index.boundary_first[t]);
+    read(section(section_tile_boundary_edges), m_index.boundary_first[t], boundary.size(), boundary.data());
+
+    tile->first_out.reserve(n + 1);
+    tile->boundary_first.reserve(n + 1);
+    tile->head.reserve(edges - boundary.size());
+    tile->length.reserve(edges - boundary.size());
+    tile->travel_time.reserve(edges - boundary.size());
+    tile->boundary_head.reserve(boundary.size());
+    tile->boundary_length.reserve(boundary.size());
+    tile->boundary_time.reserve(boundary.size());
+    std::size_t next_boundary = 0;
+    for (uint32_t local = 0; local < n; ++local) {
+        tile->first_out.push_back(static_cast<uint32_t>(tile->head.size()));
+        tile->boundary_first.push_back(static_cast<uint32_t>(tile->boundary_head.size()));
+        for (uint32_t e = first_out[local]; e < first_out[local + 1]; ++e) {
+            const uint32_t i = e - first_edge;
+            if (next_boundary < boundary.size() && boundary[next_boundary] == e) {
+                ++next_boundary;
+                tile->boundary_head.push_back(head[i]);
+                tile->boundary_length.push_back(length[i]);
+                tile->boundary_time.push_back(travel_time[i]);
+                continue;
+            }
+            if (head[i] - tile->first_node >= n) {
+                throw std::runtime_error("snapshot tile index does not match the edges: " + m_filename);
+            }
+            tile->head.push_back(static_cast<uint16_t>(head[i] - tile->first_node));
+            tile->length.push_back(length[i]);
+            tile->travel_time.push_back(travel_time[i]);
+        }
+    }
+    tile->first_out.push_back(static_cast<uint32_t>(tile->head.size()));
+    tile->boundary_first.push_back(static_cast<uint32_t>(tile->boundary_head.size()));
+    if (next_boundary != boundary.size()) {
+        throw std::runtime_error("snapshot tile index does not match the edges: " + m_filename);
+    }
+
+    tile->lat.resize(n);
+    tile->lon.resize(n);
+    tile->osm_ids.resize(n);
+    read(section(section_lat), tile->first_node, n, tile->lat.data());
+    read(section(section_lon), tile->first_node, n, tile->lon.data());
+    read(section(section_osm_ids), tile->first_node, n, tile->osm_ids.data());
+    if (!m_component_flags.empty()) {
+        tile->component.resize(n);
+        read(section(section_component), tile->first_node, n, tile->component.data());
+    }
+    return tile;
+}
+
+const TiledGraph::Tile& TiledGraph::loadTile(uint32_t t) const {
+    std::unique_ptr<Tile>& slot = m_tiles[t];
+    if (slot) {
+        m_lru.splice(m_lru.begin(), m_lru, slot->lru);
+    } else {
+        slot = readTile(t);
+        m_lru.push_front(t);
+        slot->lru = m_lru.begin();
+        m_stats.loads++;
+        m_stats.resident++;
+        m_stats.bytes += slot->bytes();
+        m_stats.peak_bytes = std::max(m_stats.peak_bytes, m_stats.bytes);
+        evict();
+    }
+    m_last = slot.get();
+    return *slot;
+}
+
+// Drops least recently used tiles until the cap is met, keeping the tile
+// just used and the one whose edges are being visited
+void TiledGraph::evict() const {
+    auto it = m_lru.end();
+    while (m_stats.bytes > m_memory_cap && it != m_lru.begin()) {
+        --it;
+        const uint32_t t = *it;
+        if (it == m_lru.begin() || t == m_pinned) continue;
+        it = m_lru.erase(it);
+        m_stats.bytes -= m_tiles[t]->bytes();
+        m_stats.resident--;
+        m_stats.evictions++;
+        if (m_last == m_tiles[t].get()) m_last = nullptr;
+        m_tiles[t].reset();
+    }
+}
+
+Node TiledGraph::coord(uint32_t v) const {
+    const Tile& tile = tileFor(v);
+    const uint32_t local = v - tile.first_node;
+    return {toDegrees(tile.lat[local]), toDegrees(tile.lon[local])};
+}
+
+int64_t TiledGraph::osmId(uint32_t v) const {
+    const Tile& tile = tileFor(v);
+    return tile.osm_ids[v - tile.first_node];
+}
+
+// Binary search over the ids in the file; one or two reads per step
+uint32_t TiledGraph::indexOf(int64_t osm_id) const {
+    const SectionEntry& ids = section(section_osm_ids);
+    const SectionEntry* by_id = m_layout.find(m_slot, section_osm_id_order);
+    auto indexAt = [&](uint32_t i) { return by_id ? readOne<uint32_t>(*by_id, i) : i; };
+    uint32_t lo = 0, hi = m_num_nodes;
+    while (lo < hi) {
+        const uint32_t mid = lo + (hi - lo) / 2;
+        const uint32_t v = indexAt(mid);
+        const int64_t id = readOne<int64_t>(ids, v);
+        if (id == osm_id) return v;
+        if (id < osm_id) lo = mid + 1;
+        else hi = mid;
+    }
+    return NodeIdMap::invalid_index;
+}
+
+uint32_t TiledGraph::nearestNode(double lat, double lon) const {
+    const SectionEntry& grid_nodes = section(section_grid_nodes);
+    std::vector<uint32_t> cell;
+    auto cellNodes = [&](std::size_t c, auto&& visit) {
+        cell.resize(m_grid_first[c + 1] - m_grid_first[c]);
+        read(grid_nodes, m_grid_first[c], cell.size(), cell.data());
+        for (uint32_t v : cell) {
+            visit(v);
+        }
+    };
+    auto coordOf = [this](uint32_t v) { return coord(v); };
+    const double inf = std::numeric_limits<double>::infinity();
+
+    uint32_t best = ringSearch(m_grid_params, cellNodes, coordOf, lat, lon, inf, [](uint32_t) { return true; });
+    if (best == std::numeric_limits<uint32_t>::max()) return 0;
+    if (m_component_flags.empty()) return best;
+    auto inGiant = [this](uint32_t v) {
+        const Tile& tile = tileFor(v);
+        return tile.component[v - tile.first_node] == 0;
+    };
+    if (inGiant(best)) return best;
+
+    const Node c = coord(best);
+    const double best_dist = haversine(lat, lon, c.lat, c.lon);
+    uint32_t giant = ringSearch(m_grid_params, cellNodes, coordOf, lat, lon, best_dist + giant_snap_slack_m, inGiant);
+    return giant != std::numeric_limits<uint32_t>::max() ? giant : best;
+}
+
+// Nodes without edges belong to no component; without components only
+// out-edges can be checked
+bool TiledGraph::hasEdges(uint32_t v) const {
+    const Tile& tile = tileFor(v);
+    const uint32_t local = v - tile.first_node;
+    if (!tile.component.empty()) return tile.component[local] != no_component;
+    return tile.first_out[local] != tile.first_out[local + 1] ||
+           tile.boundary_first[local] != tile.boundary_first[local + 1];
+}
+
+bool TiledGraph::mayReach(uint32_t s, uint32_t t) const {
+    if (s == t || m_component_flags.empty()) return true;
+    auto componentOf = [this](uint32_t v) {
+        const Tile& tile = tileFor(v);
+        return tile.component[v - tile.first_node];
+    };
+    const uint32_t cs = componentOf(s);
+    const uint32_t ct = componentOf(t);
+    if (cs == no_component || ct == no_component) return false;
+    if (cs == ct) return true;
+
+    const uint8_t fs = m_component_flags[cs];
+    const uint8_t ft = m_component_flags[ct];
+    if (ct == 0) return fs & component_reaches_giant;
+    if (cs == 0) return ft & component_reached_from_giant;
+    return true;
+}
+
+// Only runs once per query, so the edges and their geometry are read straight
+// from the file rather than kept with the tiles
+std::vector<uint32_t> TiledGraph::expandPath(const std::vector<uint32_t>& path, Metric metric) const {
+    const SectionEntry* geometry_first = m_layout.find(m_slot, section_geometry_first);
+    if (!geometry_first) return path;
+    const SectionEntry& geometry = section(section_geometry);
+    const SectionEntry& weight = section(metric == Metric::time ? section_travel_time : section_length);
+
+    std::vector<uint32_t> full;
+    std::vector<uint32_t> heads, weights, shape;
+    full.reserve(path.size());
+    for (std::size_t i = 0; i < path.size(); ++i) {
+        full.push_back(path[i]);
+        if (i + 1 == path.size()) break;
+        uint32_t range[2];
+        read(section(section_first_out), path[i], 2, range);
+        heads.resize(range[1] - range[0]);
+        weights.resize(heads.size());
+        read(section(section_head), range[0], heads.size(), heads.data());
+        read(weight, range[0], weights.size(), weights.data());
+        uint32_t best = NodeIdMap::invalid_index;
+        for (std::size_t k = 0; k < heads.size(); ++k) {
+            if (heads[k] != path[i + 1]) continue;
+            if (best == NodeIdMap::invalid_index || weights[k] < weights[best - range[0]]) {
+                best = range[0] + static_cast<uint32_t>(k);
+            }
+        }
+        if (best == NodeIdMap::invalid_index) continue;
+        uint32_t shape_range[2];
+        read(*geometry_first, best, 2, shape_range);
+        shape.resize(shape_range[1] - shape_range[0]);
+        read(geometry, shape_range[0], shape.size(), shape.data());
+        full.insert(full.end(), shape.begin(), shape.end());
+    }
+    return full;
+}
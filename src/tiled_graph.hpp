@@ -0,0 +1,142 @@
+#ifndef TILED_GRAPH
+#define TILED_GRAPH
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "graph_snapshot.hpp"
+#include "road_graph.hpp"
+
+// One graph of a snapshot, read tile by tile (see graph_tiles.hpp) instead of
+// mapped as a whole, so maps larger than memory can be routed on. A tile is
+// read with a few pread() calls the first time the search touches one of its
+// nodes; once the loaded tiles take more than the memory cap, the least
+// recently used ones are dropped again. In memory, edges that stay inside
+// their tile name the target with 16 bits; the tile's boundary edges are kept
+// apart with full node indices.
+//
+// Searchable through the same interface as RoadGraph and GraphOverlay. Only the
+// tile index, the grid cell offsets and the component flags stay loaded;
+// geometry, grid cells and OSM id lookups are read from the file when asked
+// for. Turn restrictions are not applied. Not thread-safe, even for const
+// calls, since those load tiles.
+class TiledGraph {
+public:
+    // Opens the graph of the given profile. Throws std::runtime_error like
+    // loadSnapshot, or if the snapshot was written without a tile index or
+    // spatial grid for that profile.
+    TiledGraph(const std::string& filename, Profile profile, std::size_t memory_cap);
+    ~TiledGraph();
+
+    TiledGraph(const TiledGraph&) = delete;
+    TiledGraph& operator=(const TiledGraph&) = delete;
+
+    Profile profile() const { return m_profile; }
+    uint32_t numNodes() const { return m_num_nodes; }
+    uint32_t numEdges() const { return m_num_edges; }
+    uint32_t numTiles() const { return m_index.numTiles(); }
+    // whether the snapshot has restrictions this graph ignores
+    bool hasTurnRestrictions() const { return m_has_turn_restrictions; }
+
+    Node coord(uint32_t v) const;
+    int64_t osmId(uint32_t v) const;
+    // NodeIdMap::invalid_index if the node is not part of the graph
+    uint32_t indexOf(int64_t osm_id) const;
+    // nearest node with edges, preferring the giant component like findNearestNode()
+    uint32_t nearestNode(double lat, double lon) const;
+    bool hasEdges(uint32_t v) const;
+    bool mayReach(uint32_t s, uint32_t t) const;
+    std::vector<uint32_t> expandPath(const std::vector<uint32_t>& path, Metric metric = Metric::distance) const;
+
+    struct CacheStats {
+        uint64_t loads = 0;     // tiles read from the file
+        uint64_t evictions = 0; // tiles dropped to stay under the cap
+        uint32_t resident = 0;  // tiles in memory now
+        std::size_t bytes = 0;  // memory they take
+        std::size_t peak_bytes = 0;
+    };
+    const CacheStats& cacheStats() const { return m_stats; }
+
+    template <typename F>
+    void forEachOutEdge(uint32_t v, Metric metric, F&& f) const {
+        const Tile& tile = tileFor(v);
+        const uint32_t local = v - tile.first_node;
+        const bool by_time = metric == Metric::time;
+        const std::vector<uint32_t>& weight = by_time ? tile.travel_time : tile.length;
+        const std::vector<uint32_t>& boundary_weight = by_time ? tile.boundary_time : tile.boundary_length;
+        // f may look at nodes of other tiles; this one must stay loaded meanwhile
+        const uint32_t pinned = m_pinned;
+        m_pinned = tile.index;
+        for (uint32_t i = tile.first_out[local]; i < tile.first_out[local + 1]; ++i) {
+            f(tile.first_node + tile.head[i], weight[i]);
+        }
+        for (uint32_t i = tile.boundary_first[local]; i < tile.boundary_first[local + 1]; ++i) {
+            f(tile.boundary_head[i], boundary_weight[i]);
+        }
+        m_pinned = pinned;
+    }
+
+private:
+    static constexpr uint32_t no_tile = NodeIdMap::invalid_index;
+
+    struct Tile {
+        uint32_t index = 0;
+        uint32_t first_node = 0;
+        uint32_t num_nodes = 0;
+        std::vector<uint32_t> first_out; // num_nodes + 1 offsets into the inner edges
+        std::vector<uint16_t> head;      // inner edge targets, relative to first_node
+        std::vector<uint32_t> length;
+        std::vector<uint32_t> travel_time;
+        std::vector<uint32_t> boundary_first; // num_nodes + 1 offsets into the boundary edges
+        std::vector<uint32_t> boundary_head;
+        std::vector<uint32_t> boundary_length;
+        std::vector<uint32_t> boundary_time;
+        std::vector<int32_t> lat;
+        std::vector<int32_t> lon;
+        std::vector<int64_t> osm_ids;
+        std::vector<uint32_t> component; // empty if the graph has none
+        std::list<uint32_t>::iterator lru;
+
+        std::size_t bytes() const;
+    };
+
+    const Tile& tileFor(uint32_t v) const {
+        if (m_last && v - m_last->first_node < m_last->num_nodes) return *m_last;
+        return loadTile(m_index.tileOf(v));
+    }
+    const Tile& loadTile(uint32_t t) const;
+    std::unique_ptr<Tile> readTile(uint32_t t) const;
+    void evict() const;
+
+    const SectionEntry& section(uint32_t id) const;
+    template <typename T>
+    void read(const SectionEntry& entry, uint64_t first, std::size_t count, T* out) const;
+    template <typename T>
+    T readOne(const SectionEntry& entry, uint64_t index) const;
+
+    std::string m_filename;
+    int m_fd = -1;
+    Profile m_profile;
+    std::size_t m_slot = 0;
+    SnapshotLayout m_layout;
+    uint32_t m_num_nodes = 0;
+    uint32_t m_num_edges = 0;
+    bool m_has_turn_restrictions = false;
+    TileIndex m_index;                      // boundary_edges stays in the file
+    GridParams m_grid_params{};
+    std::vector<uint32_t> m_grid_first;     // cells stay in the file
+    std::vector<uint8_t> m_component_flags;
+
+    std::size_t m_memory_cap;
+    mutable std::vector<std::unique_ptr<Tile>> m_tiles; // per tile, null unless loaded
+    mutable std::list<uint32_t> m_lru;                  // loaded tiles, most recently used first
+    mutable const Tile* m_last = nullptr;
+    mutable uint32_t m_pinned = no_tile;
+    mutable CacheStats m_stats;
+};
+
+#endif
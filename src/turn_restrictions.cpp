@@ -0,0 +1,191 @@
+#include "turn_restrictions.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+#include <osmium/osm/relation.hpp>
+
+#include "road_graph.hpp"
+#include "way_tags.hpp"
+
+uint32_t TurnTable::viaSlot(uint32_t v) const {
+    return static_cast<uint32_t>(std::lower_bound(via_nodes.begin(), via_nodes.end(), v) - via_nodes.begin());
+}
+
+uint32_t TurnTable::inEdgeIndex(uint32_t slot, uint32_t e) const {
+    const uint32_t* begin = in_edges.begin() + in_first[slot];
+    const uint32_t* end = in_edges.begin() + in_first[slot + 1];
+    return static_cast<uint32_t>(std::lower_bound(begin, end, e) - in_edges.begin());
+}
+
+void parseTurnRestrictions(const osmium::Relation& relation, Profile profile,
+                           std::vector<TurnRestriction>& restrictions) {
+    const osmium::TagList& tags = relation.tags();
+    const char* type = tags["type"];
+    if (!type || !tagEquals(type, "restriction")) return;
+
+    // a vehicle-specific tag wins over the general one
+    const char* vehicle = nullptr;
+    const char* value = nullptr;
+    switch (profile) {
+    case Profile::car:
+        vehicle = "motorcar";
+        value = tags["restriction:motorcar"];
+        break;
+    case Profile::bike:
+        vehicle = "bicycle";
+        value = tags["restriction:bicycle"];
+        break;
+    case Profile::foot:
+        return;
+    }
+    if (!value) value = tags["restriction"];
+    if (!value) return;
+    const char* except = tags["except"];
+    if (except && std::strstr(except, vehicle)) return;
+
+    TurnRule rule;
+    if (tagStartsWith(value, "no_")) {
+        rule = TurnRule::no;
+    } else if (tagStartsWith(value, "only_")) {
+        rule = TurnRule::only;
+    } else {
+        return;
+    }
+
+    std::vector<int64_t> from, to;
+    int64_t via = 0;
+    bool has_via = false;
+    for (const auto& member : relation.members()) {
+        const char* role = member.role();
+        if (member.type() == osmium::item_type::way) {
+            if (tagEquals(role, "from")) from.push_back(member.ref());
+            else if (tagEquals(role, "to")) to.push_back(member.ref());
+            else if (tagEquals(role, "via")) return; // via ways are not supported
+        } else if (member.type() == osmium::item_type::node && tagEquals(role, "via")) {
+            if (has_via) return;
+            via = member.ref();
+            has_via = true;
+        }
+    }
+    if (!has_via) return;
+    // no_entry and no_exit may list several from or to ways
+    for (int64_t f : from) {
+        for (int64_t t : to) {
+            restrictions.push_back({f, via, t, relation.id(), rule});
+        }
+    }
+}
+
+void sortTurnRestrictions(std::vector<TurnRestriction>& restrictions) {
+    std::sort(restrictions.begin(), restrictions.end(), [](const TurnRestriction& a, const TurnRestriction& b) {
+        if (a.via_node != b.via_node) return a.via_node < b.via_node;
+        if (a.from_way != b.from_way) return a.from_way < b.from_way;
+        if (a.to_way != b.to_way) return a.to_way < b.to_way;
+        if (a.rule != b.rule) return a.rule < b.rule;
+        return a.relation < b.relation;
+    });
+}
+
+uint32_t resolveTurnRestrictions(RoadGraph& g) {
+    g.turns = TurnTable();
+    if (g.turn_restrictions.empty()) return 0;
+    const uint32_t n = g.numNodes();
+
+    auto wayIndex = [&g](int64_t way_id) {
+        auto it = std::lower_bound(g.way_ids.begin(), g.way_ids.end(), way_id);
+        if (it == g.way_ids.end() || *it != way_id) return NodeIdMap::invalid_index;
+        return static_cast<uint32_t>(it - g.way_ids.begin());
+    };
+
+    // restrictions in graph terms, grouped by via node
+    struct Resolved {
+        uint32_t via, from, to;
+        TurnRule rule;
+    };
+    std::vector<Resolved> resolved;
+    for (const TurnRestriction& r : g.turn_restrictions) {
+        const uint32_t via = g.node_ids.indexOf(r.via_node);
+        const uint32_t from = wayIndex(r.from_way);
+        const uint32_t to = wayIndex(r.to_way);
+        if (via == NodeIdMap::invalid_index || from == NodeIdMap::invalid_index || to == NodeIdMap::invalid_index) continue;
+        if (g.first_out[via] == g.first_out[via + 1]) continue; // contracted away or isolated
+        resolved.push_back({via, from, to, r.rule});
+    }
+    if (resolved.empty()) return 0;
+    std::sort(resolved.begin(), resolved.end(), [](const Resolved& a, const Resolved& b) { return a.via < b.via; });
+
+    std::vector<uint32_t> via_nodes;
+    std::vector<uint64_t> via_bits((n + 63) / 64, 0);
+    for (const Resolved& r : resolved) {
+        if (via_nodes.empty() || via_nodes.back() != r.via) {
+            via_nodes.push_back(r.via);
+            via_bits[r.via >> 6] |= uint64_t(1) << (r.via & 63);
+        }
+    }
+    auto slotOf = [&via_nodes](uint32_t v) {
+        return static_cast<uint32_t>(std::lower_bound(via_nodes.begin(), via_nodes.end(), v) - via_nodes.begin());
+    };
+    auto isVia = [&via_bits](uint32_t v) { return (via_bits[v >> 6] >> (v & 63)) & 1; };
+
+    // in-edges of the via nodes, counted and then filled in one scan each;
+    // edge ids come out ascending per node
+    const uint32_t slots = static_cast<uint32_t>(via_nodes.size());
+    std::vector<uint32_t> in_first(slots + 1, 0);
+    for (uint32_t e = 0; e < g.numEdges(); ++e) {
+        if (isVia(g.head[e])) in_first[slotOf(g.head[e]) + 1]++;
+    }
+    for (uint32_t k = 0; k < slots; ++k) {
+        in_first[k + 1] += in_first[k];
+    }
+    std::vector<uint32_t> in_edges(in_first[slots]), in_tail(in_first[slots]);
+    std::vector<uint32_t> next(in_first.begin(), in_first.end() - 1);
+    for (uint32_t u = 0; u < n; ++u) {
+        for (uint32_t e = g.first_out[u]; e < g.first_out[u + 1]; ++e) {
+            if (!isVia(g.head[e])) continue;
+            const uint32_t slot = next[slotOf(g.head[e])]++;
+            in_edges[slot] = e;
+            in_tail[slot] = u;
+        }
+    }
+
+    std::vector<uint32_t> forbidden_first(slots + 1, 0);
+    for (uint32_t k = 0; k < slots; ++k) {
+        const uint32_t v = via_nodes[k];
+        const uint32_t out_degree = g.first_out[v + 1] - g.first_out[v];
+        forbidden_first[k + 1] = forbidden_first[k] + (in_first[k + 1] - in_first[k]) * out_degree;
+    }
+    std::vector<uint64_t> forbidden((forbidden_first[slots] + 63) / 64, 0);
+
+    uint32_t applied = 0;
+    for (const Resolved& r : resolved) {
+        const uint32_t k = slotOf(r.via);
+        const uint32_t out_begin = g.first_out[r.via];
+        const uint32_t out_degree = g.first_out[r.via + 1] - out_begin;
+        bool used = false;
+        for (uint32_t i = in_first[k]; i < in_first[k + 1]; ++i) {
+            if (g.edge_way[in_edges[i]] != r.from) continue;
+            for (uint32_t c = 0; c < out_degree; ++c) {
+                const uint32_t f = out_begin + c;
+                bool onto_to = g.edge_way[f] == r.to;
+                // no_u_turn names the same way twice; only turning back is meant.
+                // An only_ rule on one way keeps to it in either direction.
+                if (r.rule == TurnRule::no && r.from == r.to) onto_to = onto_to && g.head[f] == in_tail[i];
+                if (onto_to == (r.rule == TurnRule::no)) {
+                    const uint64_t bit = forbidden_first[k] + uint64_t(i - in_first[k]) * out_degree + c;
+                    forbidden[bit >> 6] |= uint64_t(1) << (bit & 63);
+                }
+            }
+            used = true;
+        }
+        if (used) applied++;
+    }
+
+    g.turns.via_bits = std::move(via_bits);
+    g.turns.via_nodes = std::move(via_nodes);
+    g.turns.in_first = std::move(in_first);
+    g.turns.in_edges = std::move(in_edges);
+    g.turns.forbidden_first = std::move(forbidden_first);
+    g.turns.forbidden = std::move(forbidden);
+    return applied;
+}
@@ -0,0 +1,84 @@
+#ifndef TURN_RESTRICTIONS
+#define TURN_RESTRICTIONS
+
+#include <cstdint>
+#include <vector>
+
+#include "graph_array.hpp"
+#include "profile.hpp"
+
+namespace osmium {
+class Relation;
+}
+
+struct RoadGraph;
+
+// no_left_turn, no_u_turn, ... forbid the one turn; only_straight_on,
+// only_right_turn, ... forbid every other turn out of the from way
+enum class TurnRule : uint8_t { no, only };
+
+// A turn restriction relation with a via node, in OSM ids. Kept with the graph
+// so the turn table can be rebuilt whenever the edges are renumbered, and
+// with its relation id so updates can replace it.
+struct TurnRestriction {
+    int64_t from_way;
+    int64_t via_node;
+    int64_t to_way;
+    int64_t relation;
+    TurnRule rule;
+    uint8_t reserved[7]{}; // zero, so snapshots hold no uninitialised padding
+};
+static_assert(sizeof(TurnRestriction) == 40, "TurnRestriction is stored in snapshots as is");
+
+// Turn restrictions resolved against the edges of one graph. Only via nodes
+// get extra data: a bit per node says whether it is one, and for each via
+// node its in-edges are listed with one row of bits per in-edge, one bit per
+// out-edge, set where that turn is forbidden. Everything else costs nothing.
+struct TurnTable {
+    GraphArray<uint64_t> via_bits;        // bit v set if node v is a via node
+    GraphArray<uint32_t> via_nodes;       // ascending
+    GraphArray<uint32_t> in_first;        // via_nodes.size() + 1 offsets into in_edges
+    GraphArray<uint32_t> in_edges;        // edges into each via node, ascending
+    GraphArray<uint32_t> forbidden_first; // via_nodes.size() + 1 bit offsets into forbidden
+    GraphArray<uint64_t> forbidden;       // per via node an in-degree x out-degree bit matrix
+
+    bool empty() const { return via_nodes.empty(); }
+
+    // number of (via node, in-edge) pairs, the extra search states a
+    // turn-aware search needs on top of one per node
+    uint32_t numInEdges() const { return static_cast<uint32_t>(in_edges.size()); }
+
+    // false for nodes past the graph the table was built for, such as nodes
+    // a GraphOverlay added
+    bool isVia(uint32_t v) const { return (v >> 6) < via_bits.size() && (via_bits[v >> 6] >> (v & 63)) & 1; }
+
+    // position of via node v in via_nodes
+    uint32_t viaSlot(uint32_t v) const;
+
+    // position in in_edges of edge e, which enters the via node at slot
+    uint32_t inEdgeIndex(uint32_t slot, uint32_t e) const;
+
+    // whether arriving over in_edges[in_index] and leaving over the out-edge
+    // with rank out_rank (e - first_out[v]) of the node's out_degree is forbidden
+    bool forbiddenTurn(uint32_t slot, uint32_t in_index, uint32_t out_rank, uint32_t out_degree) const {
+        const uint64_t bit = forbidden_first[slot] + uint64_t(in_index - in_first[slot]) * out_degree + out_rank;
+        return (forbidden[bit >> 6] >> (bit & 63)) & 1;
+    }
+};
+
+// Appends the restrictions of a type=restriction relation that apply to the
+// profile: "restriction:motorcar" or "restriction:bicycle" if present, else
+// "restriction", unless an "except" tag names the vehicle. Pedestrians get
+// none. Relations with a via way are skipped.
+void parseTurnRestrictions(const osmium::Relation& relation, Profile profile,
+                           std::vector<TurnRestriction>& restrictions);
+
+// Puts restrictions in the order the graph keeps them: by via node, from
+// way, to way, rule and relation
+void sortTurnRestrictions(std::vector<TurnRestriction>& restrictions);
+
+// Builds g.turns from g.turn_restrictions. Restrictions whose ways or via node
+// are not part of the graph are ignored. Returns the number that were applied.
+uint32_t resolveTurnRestrictions(RoadGraph& g);
+
+#endif
@@ -0,0 +1,53 @@
+#include "way_tags.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+// "50", "50 km/h" or "30 mph"; "none", "signals" and zone codes give 0
+static uint16_t parseMaxspeed(const char* value) {
+    char* end = nullptr;
+    double kmh = std::strtod(value, &end);
+    if (end == value || !(kmh > 0)) return 0;
+    if (std::strstr(end, "mph")) kmh *= 1.609344;
+    return static_cast<uint16_t>(std::min(std::lround(kmh * 10.0), 65535L));
+}
+
+WayAttributes classifyWay(const osmium::TagList& tags) {
+    WayAttributes attributes;
+    for (const osmium::Tag& tag : tags) {
+        const char* key = tag.key();
+        const char* value = tag.value();
+        switch (key[0]) {
+        case 'a':
+            if (tagEquals(key, "access")) attributes.access = classifyAccess(value);
+            break;
+        case 'b':
+            if (tagEquals(key, "bicycle")) attributes.bicycle = classifyAccess(value);
+            break;
+        case 'c':
+            if (tagEquals(key, "cycleway") && tagStartsWith(value, "opposite")) attributes.bike_contraflow = true;
+            break;
+        case 'f':
+            if (tagEquals(key, "foot")) attributes.foot = classifyAccess(value);
+            break;
+        case 'h':
+            if (tagEquals(key, "highway")) attributes.highway = classifyHighway(value);
+            break;
+        case 'j':
+            if (tagEquals(key, "junction")) attributes.roundabout = tagEquals(value, "roundabout");
+            break;
+        case 'm':
+            if (tagEquals(key, "motor_vehicle")) attributes.motor_vehicle = classifyAccess(value);
+            else if (tagEquals(key, "maxspeed")) attributes.maxspeed = parseMaxspeed(value);
+            break;
+        case 'o':
+            if (tagEquals(key, "oneway")) attributes.oneway = classifyOneway(value);
+            else if (tagEquals(key, "oneway:bicycle") && tagEquals(value, "no")) attributes.bike_contraflow = true;
+            else if (tagEquals(key, "oneway:foot")) attributes.foot_oneway = tagEquals(value, "yes");
+            break;
+        }
+    }
+    return attributes;
+}
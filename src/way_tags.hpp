@@ -0,0 +1,138 @@
+#ifndef WAY_TAGS
+#define WAY_TAGS
+
+#include <cstdint>
+#include <osmium/osm/tag.hpp>
+
+// Highway classes the profiles tell apart; any other highway value is other
+enum class HighwayClass : uint8_t {
+    none, // no highway tag
+    motorway, motorway_link, trunk, trunk_link, primary, primary_link,
+    secondary, secondary_link, tertiary, tertiary_link, unclassified, residential,
+    living_street, service, road, track, path, cycleway, footway, pedestrian,
+    steps, bridleway, corridor, other
+};
+
+// Value of an access-style tag (access, motor_vehicle, bicycle, foot)
+enum class TagAccess : uint8_t {
+    unset,
+    allowed, // yes, designated or permissive
+    denied,  // no
+    other
+};
+
+// oneway=yes/true/1 is forward, oneway=-1 backward
+enum class TagOneway : uint8_t { unset, forward, backward };
+
+// Everything the profiles read from a way's tags, gathered in one pass over
+// the tag list. Fits in 6 bytes and needs no allocation.
+struct WayAttributes {
+    HighwayClass highway : 5;
+    TagAccess access : 2;
+    TagAccess motor_vehicle : 2;
+    TagAccess bicycle : 2;
+    TagAccess foot : 2;
+    TagOneway oneway : 2;
+    bool roundabout : 1;      // junction=roundabout
+    bool bike_contraflow : 1; // oneway:bicycle=no or cycleway=opposite*
+    bool foot_oneway : 1;     // oneway:foot=yes
+    uint16_t maxspeed;        // 0.1 km/h, 0 if missing or not numeric
+
+    WayAttributes()
+        : highway(HighwayClass::none), access(TagAccess::unset), motor_vehicle(TagAccess::unset),
+          bicycle(TagAccess::unset), foot(TagAccess::unset), oneway(TagOneway::unset),
+          roundabout(false), bike_contraflow(false), foot_oneway(false), maxspeed(0) {}
+};
+static_assert(sizeof(WayAttributes) <= 6, "WayAttributes should stay packed");
+
+constexpr bool tagEquals(const char* a, const char* b) {
+    while (*a && *a == *b) {
+        ++a;
+        ++b;
+    }
+    return *a == *b;
+}
+
+constexpr bool tagStartsWith(const char* value, const char* prefix) {
+    while (*prefix && *value == *prefix) {
+        ++value;
+        ++prefix;
+    }
+    return *prefix == '\0';
+}
+
+// Switches on the first letter, so a value is compared with at most a few
+// candidates
+constexpr HighwayClass classifyHighway(const char* value) {
+    switch (value[0]) {
+    case 'b':
+        if (tagEquals(value, "bridleway")) return HighwayClass::bridleway;
+        break;
+    case 'c':
+        if (tagEquals(value, "cycleway")) return HighwayClass::cycleway;
+        if (tagEquals(value, "corridor")) return HighwayClass::corridor;
+        break;
+    case 'f':
+        if (tagEquals(value, "footway")) return HighwayClass::footway;
+        break;
+    case 'l':
+        if (tagEquals(value, "living_street")) return HighwayClass::living_street;
+        break;
+    case 'm':
+        if (tagEquals(value, "motorway")) return HighwayClass::motorway;
+        if (tagEquals(value, "motorway_link")) return HighwayClass::motorway_link;
+        break;
+    case 'p':
+        if (tagEquals(value, "primary")) return HighwayClass::primary;
+        if (tagEquals(value, "primary_link")) return HighwayClass::primary_link;
+        if (tagEquals(value, "path")) return HighwayClass::path;
+        if (tagEquals(value, "pedestrian")) return HighwayClass::pedestrian;
+        break;
+    case 'r':
+        if (tagEquals(value, "residential")) return HighwayClass::residential;
+        if (tagEquals(value, "road")) return HighwayClass::road;
+        break;
+    case 's':
+        if (tagEquals(value, "secondary")) return HighwayClass::secondary;
+        if (tagEquals(value, "secondary_link")) return HighwayClass::secondary_link;
+        if (tagEquals(value, "service")) return HighwayClass::service;
+        if (tagEquals(value, "steps")) return HighwayClass::steps;
+        break;
+    case 't':
+        if (tagEquals(value, "tertiary")) return HighwayClass::tertiary;
+        if (tagEquals(value, "tertiary_link")) return HighwayClass::tertiary_link;
+        if (tagEquals(value, "trunk")) return HighwayClass::trunk;
+        if (tagEquals(value, "trunk_link")) return HighwayClass::trunk_link;
+        if (tagEquals(value, "track")) return HighwayClass::track;
+        break;
+    case 'u':
+        if (tagEquals(value, "unclassified")) return HighwayClass::unclassified;
+        break;
+    }
+    return HighwayClass::other;
+}
+
+constexpr TagAccess classifyAccess(const char* value) {
+    if (tagEquals(value, "yes") || tagEquals(value, "designated") || tagEquals(value, "permissive")) {
+        return TagAccess::allowed;
+    }
+    if (tagEquals(value, "no")) return TagAccess::denied;
+    return TagAccess::other;
+}
+
+constexpr TagOneway classifyOneway(const char* value) {
+    if (tagEquals(value, "yes") || tagEquals(value, "true") || tagEquals(value, "1")) return TagOneway::forward;
+    if (tagEquals(value, "-1")) return TagOneway::backward;
+    return TagOneway::unset;
+}
+
+static_assert(classifyHighway("tertiary_link") == HighwayClass::tertiary_link, "highway classifier");
+static_assert(classifyHighway("turning_circle") == HighwayClass::other, "highway classifier");
+static_assert(classifyAccess("permissive") == TagAccess::allowed, "access classifier");
+static_assert(classifyOneway("-1") == TagOneway::backward, "oneway classifier");
+
+// Reads the tags of one way. Keys the profiles do not use are skipped after
+// looking at their first letter.
+WayAttributes classifyWay(const osmium::TagList& tags);
+
+#endif